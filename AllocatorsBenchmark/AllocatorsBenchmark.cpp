@@ -0,0 +1,246 @@
+//================================================================================================
+// AllocatorsBenchmark
+//
+// Measures the per-operation cost of the suballocators.  Build in Release for meaningful numbers.
+//================================================================================================
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "BuddySuballocator.h"
+#include "ConcurrentRingSuballocator.h"
+#include "FileStagingPipeline.h"
+#include "PoolSuballocator.h"
+#include "RingSuballocator.h"
+
+namespace AllocatorsBenchmark
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Prevents the optimizer from discarding benchmark results
+    volatile size_t g_Sink = 0;
+
+    double ElapsedNs(Clock::time_point Start, Clock::time_point End)
+    {
+        return double(std::chrono::duration_cast<std::chrono::nanoseconds>(End - Start).count());
+    }
+
+    // Allocates every slot, then frees them all, repeatedly.
+    // Reports the average cost of one allocate + free pair.
+    void PoolVersusBuddy()
+    {
+        constexpr size_t NumSlots = 1 << 16;
+        constexpr int Iterations = 64;
+
+        std::vector<uint32_t> Offsets(NumSlots);
+        std::vector<TBuddyBlock<uint32_t>> Blocks(NumSlots);
+
+        TPoolSuballocator<uint32_t> Pool(NumSlots);
+        auto Start = Clock::now();
+        for (int i = 0; i < Iterations; ++i)
+        {
+            for (size_t j = 0; j < NumSlots; ++j)
+                Offsets[j] = Pool.Allocate();
+            for (size_t j = 0; j < NumSlots; ++j)
+                Pool.Free(Offsets[j]);
+        }
+        double PoolNs = ElapsedNs(Start, Clock::now()) / (double(NumSlots) * Iterations);
+        g_Sink = g_Sink + Pool.FreeCount();
+
+        TBuddySuballocator<uint32_t> Buddy(NumSlots);
+        Start = Clock::now();
+        for (int i = 0; i < Iterations; ++i)
+        {
+            for (size_t j = 0; j < NumSlots; ++j)
+                Blocks[j] = Buddy.Allocate(1);
+            for (size_t j = 0; j < NumSlots; ++j)
+                Buddy.Free(Blocks[j]);
+        }
+        double BuddyNs = ElapsedNs(Start, Clock::now()) / (double(NumSlots) * Iterations);
+        g_Sink = g_Sink + Buddy.TotalFree();
+
+        printf("Fixed-size slots (%zu slots, allocate + free)\n", NumSlots);
+        printf("  TPoolSuballocator   %8.2f ns/op\n", PoolNs);
+        printf("  TBuddySuballocator  %8.2f ns/op\n", BuddyNs);
+        printf("  Pool / Buddy        %8.2f\n\n", PoolNs / BuddyNs);
+    }
+
+    // Several producer threads allocate small ranges from a shared ring while one consumer thread
+    // frees them.  Compares the lock-free ring against a TRingSuballocator behind a mutex.
+    // Reports the average wall time per allocation across all producers.  This measures the cost
+    // of the lock-free ring, not a speedup: on few cores the mutex ring is usually faster.
+    void ConcurrentRingVersusMutex()
+    {
+        constexpr size_t RingSize = 1 << 16;
+        constexpr size_t NumProducers = 4;
+        constexpr size_t AllocationsPerProducer = 1 << 18;
+        constexpr size_t TotalAllocations = NumProducers * AllocationsPerProducer;
+
+        auto RunProducers = [](auto&& Produce, auto&& Consume)
+        {
+            std::atomic<size_t> Remaining{ NumProducers };
+            auto Start = Clock::now();
+            std::vector<std::thread> Producers;
+            for (size_t p = 0; p < NumProducers; ++p)
+            {
+                Producers.emplace_back([&]()
+                {
+                    for (size_t i = 0; i < AllocationsPerProducer; ++i)
+                        Produce(1 + (i & 7));
+                    --Remaining;
+                });
+            }
+
+            while (Remaining > 0)
+                Consume();
+            for (auto& Producer : Producers)
+                Producer.join();
+            Consume();
+            return ElapsedNs(Start, Clock::now()) / double(TotalAllocations);
+        };
+
+        TConcurrentRingSuballocator<uint32_t> LockFree(RingSize);
+        double LockFreeNs = RunProducers(
+            [&](size_t Size)
+            {
+                TRingReservation<uint32_t> Reservation;
+                while (!LockFree.TryReserve(Size, 1, Reservation))
+                    std::this_thread::yield();
+                LockFree.Commit(Reservation);
+            },
+            [&]()
+            {
+                if (LockFree.Free(RingSize) == 0)
+                    std::this_thread::yield();
+            });
+        g_Sink = g_Sink + LockFree.FreeSize();
+
+        TRingSuballocator<uint32_t> Locked(RingSize);
+        std::mutex Mutex;
+        double MutexNs = RunProducers(
+            [&](size_t Size)
+            {
+                for (;;)
+                {
+                    {
+                        std::lock_guard<std::mutex> Lock(Mutex);
+                        uint32_t Offset;
+                        if (Locked.TryAllocate(Size, 1, Offset))
+                            return;
+                    }
+                    std::this_thread::yield();
+                }
+            },
+            [&]()
+            {
+                size_t Freed;
+                {
+                    std::lock_guard<std::mutex> Lock(Mutex);
+                    Freed = Locked.AllocatedSize();
+                    Locked.Free(Freed);
+                }
+                if (Freed == 0)
+                    std::this_thread::yield();
+            });
+        g_Sink = g_Sink + Locked.FreeSize();
+
+        printf("Multi-producer ring (%zu producers, 1 consumer, %zu allocations)\n", NumProducers, TotalAllocations);
+        printf("  TConcurrentRingSuballocator  %8.2f ns/op\n", LockFreeNs);
+        printf("  TRingSuballocator + mutex    %8.2f ns/op\n", MutexNs);
+        printf("  Lock-free / Mutex            %8.2f\n\n", LockFreeNs / MutexNs);
+    }
+
+    // Streams a local file through a staging buffer and reports throughput.  The consumer touches
+    // every byte.  Compares TFileStagingPipeline against reading each chunk into a temporary
+    // vector and copying it into the staging buffer.
+    void FileStagingThroughput()
+    {
+        constexpr size_t FileSize = size_t(256) << 20;
+        constexpr size_t BufferSize = size_t(8) << 20;
+        constexpr size_t ChunkSize = size_t(1) << 20;
+        const char* Path = "AllocatorsBenchmark.tmp";
+
+        FILE* pFile = fopen(Path, "wb");
+        if (!pFile)
+        {
+            printf("File staging: cannot create %s\n\n", Path);
+            return;
+        }
+
+        std::vector<uint8_t> Block(ChunkSize);
+        for (size_t i = 0; i < Block.size(); ++i)
+            Block[i] = uint8_t(i * 31);
+        for (size_t Written = 0; Written < FileSize; Written += Block.size())
+            fwrite(Block.data(), 1, Block.size(), pFile);
+        fclose(pFile);
+
+        std::unique_ptr<uint64_t[]> Buffer(new uint64_t[BufferSize / sizeof(uint64_t)]);
+        auto Touch = [](const uint8_t* pData, size_t Size)
+        {
+            size_t Sum = 0;
+            for (size_t i = 0; i < Size; i += 64)
+                Sum += pData[i];
+            return Sum;
+        };
+
+        auto MBPerSecond = [](double Ns)
+        {
+            return double(FileSize) / (1024.0 * 1024.0) / (Ns * 1e-9);
+        };
+
+        double PipelineMBs[2];
+        StagingReadMode Modes[2] = { StagingReadMode::Read, StagingReadMode::MemoryMap };
+        for (int m = 0; m < 2; ++m)
+        {
+            TFileStagingPipeline<uint32_t> Pipeline(Buffer.get(), BufferSize, ChunkSize);
+            auto Start = Clock::now();
+            Pipeline.Start(Path, Modes[m]);
+            StagedChunk Chunk;
+            while (Pipeline.AcquireChunk(Chunk))
+            {
+                g_Sink = g_Sink + Touch(Chunk.Data, Chunk.Size);
+                Pipeline.ReleaseChunk();
+            }
+            PipelineMBs[m] = MBPerSecond(ElapsedNs(Start, Clock::now()));
+        }
+
+        // Baseline: read into a temporary vector, then copy into the staging ring
+        TRingSuballocator<uint32_t> Ring(BufferSize, true);
+        uint8_t* pStaging = reinterpret_cast<uint8_t*>(Buffer.get());
+        auto Start = Clock::now();
+        pFile = fopen(Path, "rb");
+        for (;;)
+        {
+            size_t Read = fread(Block.data(), 1, Block.size(), pFile);
+            if (Read == 0)
+                break;
+
+            uint32_t Offset = Ring.Allocate(Read);
+            memcpy(pStaging + Offset, Block.data(), Read);
+            g_Sink = g_Sink + Touch(pStaging + Offset, Read);
+            Ring.Free(Read);
+        }
+        fclose(pFile);
+        double CopyMBs = MBPerSecond(ElapsedNs(Start, Clock::now()));
+        remove(Path);
+
+        printf("File staging (%zu MB file, %zu MB buffer, %zu KB chunks)\n", FileSize >> 20, BufferSize >> 20, ChunkSize >> 10);
+        printf("  TFileStagingPipeline (read)  %8.1f MB/s\n", PipelineMBs[0]);
+        printf("  TFileStagingPipeline (map)   %8.1f MB/s\n", PipelineMBs[1]);
+        printf("  fread + copy                 %8.1f MB/s\n\n", CopyMBs);
+    }
+}
+
+int main()
+{
+    AllocatorsBenchmark::PoolVersusBuddy();
+    AllocatorsBenchmark::ConcurrentRingVersusMutex();
+    AllocatorsBenchmark::FileStagingThroughput();
+    return 0;
+}
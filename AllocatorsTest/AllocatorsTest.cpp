@@ -1,6 +1,18 @@
 #include <gtest/gtest.h>
+#include <thread>
+#include "AsyncSuballocator.h"
 #include "BuddySuballocator.h"
+#include "ComposableSuballocator.h"
+#include "ConcurrentRingSuballocator.h"
+#include "FileStagingPipeline.h"
+#include "LinearSuballocator.h"
+#include "PoolSuballocator.h"
+#include "QuadtreeSuballocator.h"
 #include "RingSuballocator.h"
+#include "ShardedBuddySuballocator.h"
+#include "SlabSuballocator.h"
+#include "SpscByteChannel.h"
+#include "TlsfSuballocator.h"
 
 using std::cout;
 
@@ -705,6 +717,1916 @@ namespace AllocatorsTest
 		alloc.Free(bFull);
 	}
 
+	TEST_F(BuddySuballocatorTestClass, TryExpandMergesFreeBuddies)
+	{
+		TBuddySuballocator<unsigned int> alloc(32);
+
+		auto block = alloc.Allocate(4);
+		EXPECT_EQ(0u, block.Start());
+		EXPECT_TRUE(alloc.IsBlockFree(TBuddyBlock<unsigned int>(4, 2)));
+
+		// Promote 4 -> 16 in place
+		EXPECT_TRUE(alloc.TryExpand(block, 13));
+		EXPECT_EQ(0u, block.Start());
+		EXPECT_EQ(16u, block.Size());
+		EXPECT_EQ(16u, alloc.TotalFree());
+		EXPECT_FALSE(alloc.IsBlockFree(TBuddyBlock<unsigned int>(4, 2)));
+
+		// Expanding to a size already held is a no-op
+		EXPECT_TRUE(alloc.TryExpand(block, 16));
+		EXPECT_EQ(16u, block.Size());
+
+		alloc.Free(block);
+		EXPECT_EQ(32u, alloc.MaxAllocationSize());
+	}
+
+	TEST_F(BuddySuballocatorTestClass, TryExpandFailsWithoutModifyingState)
+	{
+		TBuddySuballocator<unsigned int> alloc(16);
+
+		auto b0 = alloc.Allocate(4);
+		auto b1 = alloc.Allocate(4);
+		auto b2 = alloc.Allocate(4);
+
+		// Right child can never expand in place
+		auto original = b1;
+		EXPECT_FALSE(alloc.TryExpand(b1, 8));
+		EXPECT_EQ(original, b1);
+
+		// Buddy in use
+		EXPECT_FALSE(alloc.TryExpand(b0, 8));
+
+		// First level succeeds but the second does not: nothing must change
+		alloc.Free(b1);
+		EXPECT_FALSE(alloc.TryExpand(b0, 16));
+		EXPECT_EQ(4u, b0.Size());
+		EXPECT_EQ(8u, alloc.TotalFree());
+		EXPECT_TRUE(alloc.IsBlockFree(TBuddyBlock<unsigned int>(4, 2)));
+
+		EXPECT_TRUE(alloc.TryExpand(b0, 8));
+		EXPECT_EQ(8u, b0.Size());
+		alloc.Free(b0);
+		alloc.Free(b2);
+		EXPECT_EQ(16u, alloc.MaxAllocationSize());
+	}
+
+	TEST_F(BuddySuballocatorTestClass, ShrinkFreesUpperHalves)
+	{
+		TBuddySuballocator<unsigned int> alloc(32);
+
+		auto block = alloc.Allocate(32);
+		alloc.Shrink(block, 3);
+		EXPECT_EQ(0u, block.Start());
+		EXPECT_EQ(4u, block.Size());
+		EXPECT_EQ(28u, alloc.TotalFree());
+		EXPECT_EQ(16u, alloc.MaxAllocationSize());
+
+		// The freed halves are allocatable
+		auto b4 = alloc.Allocate(4);
+		auto b8 = alloc.Allocate(8);
+		auto b16 = alloc.Allocate(16);
+		EXPECT_EQ(4u, b4.Start());
+		EXPECT_EQ(8u, b8.Start());
+		EXPECT_EQ(16u, b16.Start());
+
+		alloc.Free(b4);
+		alloc.Free(b8);
+		alloc.Free(b16);
+		alloc.Free(block);
+		EXPECT_EQ(32u, alloc.MaxAllocationSize());
+	}
+
+	TEST_F(BuddySuballocatorTestClass, FreeRightChildAfterMergeIsNotAllocated)
+	{
+		TBuddySuballocator<unsigned int> alloc(2);
+		auto b0 = alloc.Allocate(1);
+		auto b1 = alloc.Allocate(1);
+		alloc.Free(b0);
+		alloc.Free(b1);
+
+		// b1 merged into the root; freeing it again must be rejected
+		EXPECT_FALSE(alloc.TryFree(b1));
+		EXPECT_EQ(2u, alloc.TotalFree());
+	}
+
+	TEST_F(BuddySuballocatorTestClass, AllocateAlignedHonorsAlignment)
+	{
+		TBuddySuballocator<unsigned int> alloc(128);
+
+		auto b0 = alloc.Allocate(4);
+		EXPECT_EQ(0u, b0.Start());
+
+		auto aligned = alloc.AllocateAligned(4, 64);
+		EXPECT_EQ(64u, aligned.Start());
+		EXPECT_EQ(4u, aligned.Size());
+		EXPECT_EQ(120u, alloc.TotalFree());
+
+		// The last aligned slot is at 0, which is in use
+		TBuddyBlock<unsigned int> dummy;
+		bool exceptionHit = false;
+		try
+		{
+			dummy = alloc.AllocateAligned(1, 64);
+		}
+		catch (BuddySuballocatorException& e)
+		{
+			exceptionHit = e.T == BuddySuballocatorException::Type::Unavailable;
+		}
+		EXPECT_TRUE(exceptionHit);
+
+		// Small unaligned space remains usable
+		auto b1 = alloc.Allocate(1);
+		EXPECT_NE(0u, b1.Start() % 64);
+
+		alloc.Free(b0);
+		alloc.Free(b1);
+		alloc.Free(aligned);
+		EXPECT_EQ(128u, alloc.MaxAllocationSize());
+	}
+
+	TEST_F(BuddySuballocatorTestClass, AllocateInRangeStaysInWindow)
+	{
+		TBuddySuballocator<unsigned int> alloc(64);
+
+		auto b0 = alloc.AllocateInRange(4, 20, 40);
+		EXPECT_EQ(20u, b0.Start());
+		EXPECT_EQ(4u, b0.Size());
+
+		auto b1 = alloc.AllocateInRange(8, 20, 40);
+		EXPECT_EQ(24u, b1.Start());
+
+		auto b2 = alloc.AllocateInRange(8, 20, 40);
+		EXPECT_EQ(32u, b2.Start());
+
+		TBuddyBlock<unsigned int> dummy;
+		bool exceptionHit = false;
+		try
+		{
+			dummy = alloc.AllocateInRange(8, 20, 40);
+		}
+		catch (BuddySuballocatorException&)
+		{
+			exceptionHit = true;
+		}
+		EXPECT_TRUE(exceptionHit);
+
+		// Regular allocation still works outside the window
+		auto b3 = alloc.Allocate(16);
+		EXPECT_TRUE(b3.Start() + 16 <= 20 || b3.Start() >= 40);
+
+		alloc.Free(b0);
+		alloc.Free(b1);
+		alloc.Free(b2);
+		alloc.Free(b3);
+		EXPECT_EQ(64u, alloc.TotalFree());
+		EXPECT_EQ(64u, alloc.MaxAllocationSize());
+	}
+
+	TEST_F(BuddySuballocatorTestClass, AllocateAtReservesExactBlock)
+	{
+		TBuddySuballocator<unsigned int> alloc(64);
+
+		auto pinned = alloc.AllocateAt(36, 4);
+		EXPECT_EQ(36u, pinned.Start());
+		EXPECT_EQ(4u, pinned.Size());
+		EXPECT_EQ(60u, alloc.TotalFree());
+		EXPECT_EQ(32u, alloc.MaxAllocationSize());
+
+		// Regular allocations avoid the pinned block
+		auto b32 = alloc.Allocate(32);
+		EXPECT_EQ(0u, b32.Start());
+		auto b16 = alloc.Allocate(16);
+		EXPECT_EQ(48u, b16.Start());
+
+		// Restoring a second block in the same region
+		TBuddyBlock<unsigned int> restored;
+		EXPECT_TRUE(alloc.TryAllocateAt(40, 8, restored));
+		EXPECT_EQ(40u, restored.Start());
+		EXPECT_EQ(8u, restored.Size());
+
+		alloc.Free(pinned);
+		alloc.Free(b32);
+		alloc.Free(b16);
+		alloc.Free(restored);
+		EXPECT_EQ(64u, alloc.MaxAllocationSize());
+	}
+
+	TEST_F(BuddySuballocatorTestClass, AllocateAtFailsCleanly)
+	{
+		TBuddySuballocator<unsigned int> alloc(32);
+		auto b = alloc.AllocateAt(8, 2);
+		TBuddyBlock<unsigned int> out;
+
+		// Overlaps an allocated block from above and below
+		EXPECT_FALSE(alloc.TryAllocateAt(8, 2, out));
+		EXPECT_FALSE(alloc.TryAllocateAt(8, 8, out));
+		EXPECT_FALSE(alloc.TryAllocateAt(8, 1, out));
+
+		// Misaligned and out of range requests
+		EXPECT_FALSE(alloc.TryAllocateAt(2, 4, out));
+		EXPECT_FALSE(alloc.TryAllocateAt(32, 1, out));
+		EXPECT_FALSE(alloc.TryAllocateAt(0, 64, out));
+
+		// State is unchanged by the failed attempts
+		EXPECT_EQ(30u, alloc.TotalFree());
+		alloc.Free(b);
+		EXPECT_EQ(32u, alloc.MaxAllocationSize());
+	}
+
+	TEST_F(BuddySuballocatorTestClass, FreeBatchCoalesces)
+	{
+		TBuddySuballocator<unsigned int> alloc(16);
+		std::vector<TBuddyBlock<unsigned int>> blocks;
+		for (int i = 0; i < 16; ++i)
+		{
+			blocks.push_back(alloc.Allocate(1));
+		}
+
+		alloc.FreeBatch(blocks.data(), blocks.size());
+		EXPECT_EQ(16u, alloc.TotalFree());
+		EXPECT_EQ(16u, alloc.MaxAllocationSize());
+
+		// Mixed orders, partially coalescing with space already free
+		auto b8 = alloc.Allocate(8);
+		auto b4 = alloc.Allocate(4);
+		auto b2 = alloc.Allocate(2);
+		auto b1a = alloc.Allocate(1);
+		auto b1b = alloc.Allocate(1);
+		TBuddyBlock<unsigned int> batch[] = { b1b, b4, b1a };
+		alloc.FreeBatch(batch, 3);
+		EXPECT_EQ(6u, alloc.TotalFree());
+		EXPECT_FALSE(alloc.IsBlockAllocated(b4));
+		EXPECT_TRUE(alloc.IsBlockAllocated(b2));
+
+		// Invalid batches are rejected without freeing anything
+		TBuddyBlock<unsigned int> duplicate[] = { b2, b2 };
+		EXPECT_THROW(alloc.FreeBatch(duplicate, 2), BuddySuballocatorException);
+		TBuddyBlock<unsigned int> notAllocated[] = { b8, b4 };
+		EXPECT_THROW(alloc.FreeBatch(notAllocated, 2), BuddySuballocatorException);
+		EXPECT_TRUE(alloc.IsBlockAllocated(b8));
+		EXPECT_EQ(6u, alloc.TotalFree());
+
+		TBuddyBlock<unsigned int> rest[] = { b2, b8 };
+		alloc.FreeBatch(rest, 2);
+		EXPECT_EQ(16u, alloc.MaxAllocationSize());
+	}
+
+	TEST_F(BuddySuballocatorTestClass, DeferredFreeRetiresCompletedFences)
+	{
+		TDeferredBuddySuballocator<unsigned int> alloc(64);
+		uint64_t fence = 0;
+
+		// Three frames of allocations, each released after its frame's fence
+		for (int frame = 0; frame < 3; ++frame)
+		{
+			++fence;
+			for (int i = 0; i < 4; ++i)
+			{
+				alloc.FreeAfter(alloc.Allocate(4), fence);
+			}
+		}
+		EXPECT_EQ(12u, alloc.PendingFreeCount());
+		EXPECT_EQ(16u, alloc.TotalFree());
+
+		EXPECT_EQ(0u, alloc.Retire(0));
+		EXPECT_EQ(4u, alloc.Retire(1));
+		EXPECT_EQ(32u, alloc.TotalFree());
+		EXPECT_EQ(8u, alloc.PendingFreeCount());
+
+		EXPECT_EQ(8u, alloc.Retire(fence));
+		EXPECT_EQ(0u, alloc.PendingFreeCount());
+		EXPECT_EQ(64u, alloc.MaxAllocationSize());
+
+		TBuddyBlock<unsigned int> fakeBlock(0, 2);
+		EXPECT_THROW(alloc.FreeAfter(fakeBlock, fence), BuddySuballocatorException);
+
+		// Queued blocks can't be freed directly or queued twice
+		auto b1 = alloc.Allocate(4);
+		auto b2 = alloc.Allocate(4);
+		alloc.FreeAfter(b1, 1);
+		alloc.FreeAfter(b2, 1);
+		EXPECT_THROW(alloc.FreeAfter(b1, 2), BuddySuballocatorException);
+		EXPECT_THROW(alloc.Free(b1), BuddySuballocatorException);
+		EXPECT_FALSE(alloc.TryFree(b2));
+		EXPECT_EQ(2u, alloc.PendingFreeCount());
+
+		// A queued block freed another way is dropped without holding back the rest of the queue
+		alloc.FreeBatch(&b1, 1);
+		EXPECT_EQ(1u, alloc.Retire(1));
+		EXPECT_EQ(0u, alloc.PendingFreeCount());
+		EXPECT_FALSE(alloc.IsBlockAllocated(b2));
+		EXPECT_EQ(64u, alloc.TotalFree());
+
+		// Retired blocks can be queued again once reallocated
+		auto b3 = alloc.Allocate(4);
+		alloc.FreeAfter(b3, 3);
+		EXPECT_EQ(1u, alloc.Retire(3));
+	}
+
+	TEST_F(BuddySuballocatorTestClass, BlockHandleRoundTrip)
+	{
+		using IndexType = unsigned char;
+		static_assert(sizeof(TBuddyBlockHandle<IndexType>) == sizeof(IndexType), "Handle must fit in the index type");
+		static_assert(sizeof(TBuddyBlockHandle<uint32_t>) == 4, "Handle must fit in the index type");
+
+		// Every block of a 128-unit allocator round-trips through a uint8 handle
+		constexpr size_t Capacity = 128;
+		for (uint8_t order = 0; (size_t(1) << order) <= Capacity; ++order)
+		{
+			for (size_t start = 0; start < Capacity; start += size_t(1) << order)
+			{
+				TBuddyBlock<IndexType> block(IndexType(start), order);
+				TBuddyBlockHandle<IndexType> handle(block);
+				EXPECT_NE(IndexType(-1), handle.Value());
+				EXPECT_EQ(block, handle.Block());
+				EXPECT_EQ(handle, TBuddyBlockHandle<IndexType>::FromValue(handle.Value()));
+			}
+		}
+
+		// The empty block maps to the empty handle
+		EXPECT_EQ(TBuddyBlockHandle<IndexType>(), TBuddyBlockHandle<IndexType>(TBuddyBlock<IndexType>()));
+		EXPECT_EQ(TBuddyBlock<IndexType>(), TBuddyBlockHandle<IndexType>().Block());
+	}
+
+	TEST_F(BuddySuballocatorTestClass, FreeByHandle)
+	{
+		using IndexType = TBuddyIndexTypeForCapacity<64>::Type;
+		static_assert(std::is_same<IndexType, uint8_t>::value, "Expected narrowest index type");
+		static_assert(std::is_same<TBuddyIndexTypeForCapacity<256>::Type, uint16_t>::value, "Expected narrowest index type");
+		static_assert(std::is_same<TBuddyIndexTypeForCapacity<(size_t(1) << 31)>::Type, uint32_t>::value, "Expected narrowest index type");
+
+		TBuddySuballocator<IndexType> alloc(64);
+		std::vector<TBuddyBlockHandle<IndexType>> handles;
+		for (int i = 0; i < 8; ++i)
+		{
+			handles.push_back(TBuddyBlockHandle<IndexType>(alloc.Allocate(size_t(1) << (i % 3))));
+		}
+
+		for (auto handle : handles)
+		{
+			EXPECT_TRUE(alloc.TryFree(handle));
+			EXPECT_FALSE(alloc.TryFree(handle));
+		}
+		EXPECT_EQ(64u, alloc.MaxAllocationSize());
+
+		auto block = alloc.Allocate(16);
+		alloc.Free(TBuddyBlockHandle<IndexType>(block));
+		EXPECT_EQ(64u, alloc.TotalFree());
+	}
+
+	TEST_F(BuddySuballocatorTestClass, ResetReleasesEverything)
+	{
+		TBuddySuballocator<uint8_t> suballocator(128);
+
+		std::vector<TBuddyBlock<uint8_t>> blocks;
+		for (int i = 0; i < 40; ++i)
+			blocks.push_back(suballocator.Allocate(1 + i % 3));
+		EXPECT_LT(suballocator.TotalFree(), 128u);
+
+		// Run past the generation limit of uint8_t encodings to cover the full table clear
+		for (int i = 0; i < 20; ++i)
+		{
+			suballocator.Reset();
+			EXPECT_EQ(128u, suballocator.TotalFree());
+			EXPECT_EQ(128u, suballocator.MaxAllocationSize());
+			for (auto& block : blocks)
+			{
+				EXPECT_FALSE(suballocator.IsBlockAllocated(block));
+			}
+			EXPECT_FALSE(suballocator.TryFree(blocks[0]));
+
+			blocks.clear();
+			for (int j = 0; j < 40; ++j)
+				blocks.push_back(suballocator.Allocate(1 + (i + j) % 3));
+		}
+
+		// Allocations made after a reset behave normally
+		for (auto& block : blocks)
+			suballocator.Free(block);
+		EXPECT_EQ(128u, suballocator.TotalFree());
+		EXPECT_EQ(0u, suballocator.Allocate(128).Start());
+	}
+
+	TEST_F(BuddySuballocatorTestClass, DeferredResetDropsPendingFrees)
+	{
+		TDeferredBuddySuballocator<unsigned int> suballocator(64);
+		auto a = suballocator.Allocate(8);
+		suballocator.FreeAfter(a, 1);
+		suballocator.Allocate(16);
+
+		suballocator.Reset();
+		EXPECT_EQ(0u, suballocator.PendingFreeCount());
+		EXPECT_EQ(0u, suballocator.Retire(1));
+		EXPECT_EQ(64u, suballocator.TotalFree());
+	}
+
+	TEST_F(BuddySuballocatorTestClass, CheckpointRollback)
+	{
+		TBuddySuballocator<uint16_t> suballocator(256);
+
+		auto kept0 = suballocator.Allocate(4);
+		auto kept1 = suballocator.Allocate(16);
+		auto kept2 = suballocator.Allocate(1);
+		size_t totalFree = suballocator.TotalFree();
+
+		auto checkpoint = suballocator.Checkpoint();
+		EXPECT_TRUE(suballocator.InCheckpoint());
+
+		std::vector<TBuddyBlock<uint16_t>> batch;
+		for (int i = 0; i < 20; ++i)
+			batch.push_back(suballocator.Allocate(1 + i % 5));
+		batch.push_back(suballocator.AllocateAt(128, 32));
+		suballocator.Free(kept1);
+		suballocator.Free(batch[3]);
+		suballocator.Shrink(batch[20], 8);
+		EXPECT_TRUE(suballocator.TryExpand(batch[20], 16));
+		suballocator.FreeBatch(&batch[5], 4);
+
+		suballocator.Rollback(checkpoint);
+		EXPECT_EQ(totalFree, suballocator.TotalFree());
+		EXPECT_TRUE(suballocator.IsBlockAllocated(kept0));
+		EXPECT_TRUE(suballocator.IsBlockAllocated(kept1));
+		EXPECT_TRUE(suballocator.IsBlockAllocated(kept2));
+		EXPECT_TRUE(suballocator.IsBlockFree(TBuddyBlock<uint16_t>(128, 7)));
+
+		// The checkpoint stays open after a rollback
+		for (int i = 0; i < 10; ++i)
+			suballocator.Allocate(3);
+		suballocator.Rollback(checkpoint);
+		EXPECT_EQ(totalFree, suballocator.TotalFree());
+		suballocator.Commit();
+		EXPECT_FALSE(suballocator.InCheckpoint());
+
+		// The free lists are intact: everything merges back into one block
+		suballocator.Free(kept0);
+		suballocator.Free(kept1);
+		suballocator.Free(kept2);
+		EXPECT_EQ(256u, suballocator.TotalFree());
+		EXPECT_EQ(0u, suballocator.Allocate(256).Start());
+	}
+
+	TEST_F(BuddySuballocatorTestClass, NestedCheckpoints)
+	{
+		TBuddySuballocator<uint32_t> suballocator(64);
+
+		auto outer = suballocator.Checkpoint();
+		auto a = suballocator.Allocate(8);
+		auto inner = suballocator.Checkpoint();
+		auto b = suballocator.Allocate(8);
+
+		suballocator.Rollback(inner);
+		EXPECT_TRUE(suballocator.IsBlockAllocated(a));
+		EXPECT_FALSE(suballocator.IsBlockAllocated(b));
+		EXPECT_EQ(56u, suballocator.TotalFree());
+
+		suballocator.Rollback(outer);
+		EXPECT_FALSE(suballocator.IsBlockAllocated(a));
+		EXPECT_EQ(64u, suballocator.TotalFree());
+
+		// The inner checkpoint was undone along with the outer one
+		EXPECT_THROW(suballocator.Rollback(inner), BuddySuballocatorException);
+
+		// Committed checkpoints cannot be rolled back
+		suballocator.Allocate(4);
+		suballocator.Commit();
+		EXPECT_THROW(suballocator.Rollback(outer), BuddySuballocatorException);
+		EXPECT_EQ(60u, suballocator.TotalFree());
+
+		// Grow commits the open checkpoint
+		auto beforeGrow = suballocator.Checkpoint();
+		suballocator.Allocate(4);
+		suballocator.Grow();
+		EXPECT_FALSE(suballocator.InCheckpoint());
+		EXPECT_THROW(suballocator.Rollback(beforeGrow), BuddySuballocatorException);
+		EXPECT_EQ(120u, suballocator.TotalFree());
+	}
+
+	TEST_F(BuddySuballocatorTestClass, CheckpointInvalidatedByOuterRollback)
+	{
+		TBuddySuballocator<uint32_t> suballocator(64);
+
+		auto outer = suballocator.Checkpoint();
+		suballocator.Allocate(8);
+		auto inner = suballocator.Checkpoint();
+		suballocator.Allocate(8);
+		suballocator.Rollback(outer);
+
+		// Regrow the undo logs past the inner checkpoint's sizes
+		auto a = suballocator.Allocate(8);
+		suballocator.Allocate(8);
+		suballocator.Allocate(8);
+		EXPECT_THROW(suballocator.Rollback(inner), BuddySuballocatorException);
+		EXPECT_EQ(3u, suballocator.AllocationCount());
+
+		// Checkpoints taken after the rollback are valid
+		auto later = suballocator.Checkpoint();
+		suballocator.Free(a);
+		suballocator.Rollback(later);
+		EXPECT_TRUE(suballocator.IsBlockAllocated(a));
+
+		size_t count = 0;
+		suballocator.ForEachAllocated([&](const TBuddyBlock<uint32_t>&) { ++count; });
+		EXPECT_EQ(suballocator.AllocationCount(), count);
+
+		suballocator.Rollback(outer);
+		EXPECT_EQ(0u, suballocator.AllocationCount());
+		EXPECT_EQ(64u, suballocator.TotalFree());
+	}
+
+	TEST_F(BuddySuballocatorTestClass, AllocateNear)
+	{
+		TBuddySuballocator<unsigned int> suballocator(64);
+
+		// The hint block is carved directly out of a free ancestor
+		auto first = suballocator.AllocateNear(4, 41);
+		EXPECT_EQ(40u, first.Start());
+		EXPECT_EQ(2u, first.Order());
+
+		// The closest free block is in the smallest enclosing subtree of the hint
+		auto second = suballocator.AllocateNear(8, 44);
+		EXPECT_EQ(32u, second.Start());
+		auto third = suballocator.AllocateNear(1, 40);
+		EXPECT_EQ(44u, third.Start());
+		suballocator.Free(first);
+		suballocator.Free(second);
+		suballocator.Free(third);
+		EXPECT_EQ(64u, suballocator.TotalFree());
+
+		std::vector<TBuddyBlock<unsigned int>> blocks;
+		for (int i = 0; i < 16; ++i)
+			blocks.push_back(suballocator.Allocate(4));
+		suballocator.Free(blocks[2]);
+		suballocator.Free(blocks[12]);
+
+		// Normal placement would take the most recently freed block at 48
+		EXPECT_EQ(8u, suballocator.AllocateNear(4, 12).Start());
+		EXPECT_EQ(48u, suballocator.AllocateNear(4, 0).Start());
+
+		TBuddyBlock<unsigned int> block;
+		EXPECT_FALSE(suballocator.TryAllocateNear(1, 0, block));
+
+		// Hints outside the allocation space fall back to normal placement
+		suballocator.Free(blocks[7]);
+		EXPECT_TRUE(suballocator.TryAllocateNear(2, 1000, block));
+		EXPECT_EQ(28u, block.Start());
+
+		// A hint inside a large allocation searches outward from that allocation, not within it
+		TBuddySuballocator<unsigned int> large(1 << 20);
+		auto half = large.Allocate(1 << 19);
+		EXPECT_EQ(0u, half.Start());
+		EXPECT_EQ(1u << 19, large.AllocateNear(1, 12345).Start());
+		EXPECT_EQ((1u << 19) + 1, large.AllocateNear(1, 0).Start());
+	}
+
+	TEST_F(BuddySuballocatorTestClass, AllocateScatter)
+	{
+		TBuddySuballocator<unsigned int> suballocator(64);
+
+		// Fragment the space so no free block is larger than 8 units
+		std::vector<TBuddyBlock<unsigned int>> blocks;
+		for (int i = 0; i < 8; ++i)
+			blocks.push_back(suballocator.Allocate(8));
+		suballocator.Free(blocks[1]);
+		suballocator.Free(blocks[4]);
+		suballocator.Free(blocks[6]);
+		auto small = suballocator.Allocate(4);
+		EXPECT_EQ(20u, suballocator.TotalFree());
+		EXPECT_EQ(8u, suballocator.MaxAllocationSize());
+
+		TBuddyBlock<unsigned int> fragments[4];
+		TBuddyBlock<unsigned int> unused;
+		EXPECT_FALSE(suballocator.TryAllocate(18, unused));
+
+		// Two fragments can't cover 18 units, and the failure has no side effects
+		size_t count = 0;
+		EXPECT_FALSE(suballocator.TryAllocateScatter(18, 2, fragments, count));
+		EXPECT_EQ(20u, suballocator.TotalFree());
+
+		// Largest blocks first, then the smallest block that holds the remainder
+		ASSERT_TRUE(suballocator.TryAllocateScatter(18, 3, fragments, count));
+		ASSERT_EQ(3u, count);
+		EXPECT_EQ(8u, fragments[0].Size());
+		EXPECT_EQ(8u, fragments[1].Size());
+		EXPECT_EQ(2u, fragments[2].Size());
+		EXPECT_EQ(2u, suballocator.TotalFree());
+
+		suballocator.FreeBatch(fragments, count);
+		EXPECT_EQ(20u, suballocator.TotalFree());
+
+		// A request that fits in one block takes one fragment
+		EXPECT_EQ(1u, suballocator.AllocateScatter(3, 4, fragments));
+		EXPECT_EQ(4u, fragments[0].Size());
+		suballocator.Free(fragments[0]);
+
+		EXPECT_THROW(suballocator.AllocateScatter(21, 4, fragments), BuddySuballocatorException);
+		suballocator.Free(small);
+	}
+
+	TEST_F(BuddySuballocatorTestClass, PublishedStatistics)
+	{
+		TBuddySuballocator<unsigned int> suballocator(256);
+		auto stats = suballocator.ReadStatistics();
+		EXPECT_EQ(256u, stats.FreeUnits);
+		EXPECT_EQ(0u, stats.AllocationCount);
+		EXPECT_EQ(8u, stats.LargestFreeOrder);
+
+		auto a = suballocator.Allocate(100);
+		auto b = suballocator.AllocateAt(192, 16);
+		stats = suballocator.ReadStatistics();
+		EXPECT_EQ(112u, stats.FreeUnits);
+		EXPECT_EQ(suballocator.TotalFree(), stats.FreeUnits);
+		EXPECT_EQ(2u, stats.AllocationCount);
+		EXPECT_EQ(64u, stats.MaxAllocationSize());
+
+		suballocator.Shrink(a, 60);
+		EXPECT_EQ(176u, suballocator.ReadStatistics().FreeUnits);
+
+		auto checkpoint = suballocator.Checkpoint();
+		suballocator.Allocate(64);
+		suballocator.Free(b);
+		suballocator.Rollback(checkpoint);
+		suballocator.Commit();
+		stats = suballocator.ReadStatistics();
+		EXPECT_EQ(176u, stats.FreeUnits);
+		EXPECT_EQ(2u, stats.AllocationCount);
+
+		TBuddyBlock<unsigned int> blocks[] = { a, b };
+		suballocator.FreeBatch(blocks, 2);
+		stats = suballocator.ReadStatistics();
+		EXPECT_EQ(256u, stats.FreeUnits);
+		EXPECT_EQ(0u, stats.AllocationCount);
+
+		suballocator.Allocate(256);
+		stats = suballocator.ReadStatistics();
+		EXPECT_EQ(0u, stats.FreeUnits);
+		EXPECT_EQ(0u, stats.MaxAllocationSize());
+
+		suballocator.Grow();
+		suballocator.Reset();
+		stats = suballocator.ReadStatistics();
+		EXPECT_EQ(512u, stats.FreeUnits);
+		EXPECT_EQ(0u, stats.AllocationCount);
+	}
+
+	TEST_F(BuddySuballocatorTestClass, StatisticsReadConcurrently)
+	{
+		TBuddySuballocator<unsigned int> suballocator(1024);
+		std::atomic<bool> done(false);
+		std::atomic<bool> consistent(true);
+
+		// Every snapshot must describe a completed operation: blocks are always 4 units
+		std::thread reader([&]
+		{
+			while (!done.load())
+			{
+				auto stats = suballocator.ReadStatistics();
+				if (stats.FreeUnits + 4 * stats.AllocationCount != 1024)
+					consistent = false;
+			}
+		});
+
+		std::vector<TBuddyBlock<unsigned int>> blocks;
+		for (int round = 0; round < 200; ++round)
+		{
+			for (int i = 0; i < 64; ++i)
+				blocks.push_back(suballocator.Allocate(4));
+			for (auto& block : blocks)
+				suballocator.Free(block);
+			blocks.clear();
+		}
+
+		done = true;
+		reader.join();
+		EXPECT_TRUE(consistent.load());
+	}
+
+	TEST_F(BuddySuballocatorTestClass, ForEachAllocated)
+	{
+		TBuddySuballocator<unsigned int> suballocator(256);
+		auto c = suballocator.AllocateAt(192, 16);
+		auto a = suballocator.AllocateAt(0, 8);
+		auto b = suballocator.AllocateAt(64, 32);
+
+		std::vector<TBuddyBlock<unsigned int>> allocated;
+		suballocator.ForEachAllocated([&](const TBuddyBlock<unsigned int>& block) { allocated.push_back(block); });
+		ASSERT_EQ(3u, allocated.size());
+		EXPECT_EQ(a, allocated[0]);
+		EXPECT_EQ(b, allocated[1]);
+		EXPECT_EQ(c, allocated[2]);
+
+		// Free blocks fill the gaps between allocations, in address order
+		std::vector<TBuddyBlock<unsigned int>> all;
+		suballocator.ForEachFree([&](const TBuddyBlock<unsigned int>& block) { all.push_back(block); });
+		size_t freeUnits = 0;
+		for (auto& block : all)
+			freeUnits += block.Size();
+		EXPECT_EQ(suballocator.TotalFree(), freeUnits);
+
+		all.insert(all.end(), allocated.begin(), allocated.end());
+		std::sort(all.begin(), all.end(), [](const TBuddyBlock<unsigned int>& x, const TBuddyBlock<unsigned int>& y) { return x.Start() < y.Start(); });
+		size_t next = 0;
+		for (auto& block : all)
+		{
+			EXPECT_EQ(next, size_t(block.Start()));
+			next = size_t(block.Start()) + block.Size();
+		}
+		EXPECT_EQ(256u, next);
+
+		suballocator.Free(b);
+		allocated.clear();
+		suballocator.ForEachAllocated([&](const TBuddyBlock<unsigned int>& block) { allocated.push_back(block); });
+		ASSERT_EQ(2u, allocated.size());
+		EXPECT_EQ(a, allocated[0]);
+		EXPECT_EQ(c, allocated[1]);
+
+		suballocator.Reset();
+		allocated.clear();
+		suballocator.ForEachAllocated([&](const TBuddyBlock<unsigned int>& block) { allocated.push_back(block); });
+		EXPECT_TRUE(allocated.empty());
+		size_t freeCount = 0;
+		suballocator.ForEachFree([&](const TBuddyBlock<unsigned int>& block) { EXPECT_EQ(256u, block.Size()); ++freeCount; });
+		EXPECT_EQ(1u, freeCount);
+	}
+
+	class SlabSuballocatorTest : public ::testing::Test
+	{
+	protected:
+		void SetUp() override {}
+		void TearDown() override {}
+	};
+
+	TEST_F(SlabSuballocatorTest, AllocatesNonPowerOfTwoSlots)
+	{
+		TBuddySuballocator<unsigned int> buddy(256);
+		TSlabSuballocator<unsigned int> slabs(buddy, 64);
+
+		EXPECT_EQ(8u, slabs.MaxSlotSize());
+		EXPECT_EQ(3u, slabs.GetSlotSize(3));
+		EXPECT_EQ(8u, slabs.GetSlotSize(7));
+
+		// A 64-unit slab holds 21 three-unit slots
+		std::vector<unsigned int> offsets;
+		for (int i = 0; i < 21; ++i)
+		{
+			offsets.push_back(slabs.Allocate(3));
+		}
+		EXPECT_EQ(1u, slabs.SlabsInUse());
+		EXPECT_EQ(192u, buddy.TotalFree());
+		for (size_t i = 1; i < offsets.size(); ++i)
+		{
+			EXPECT_EQ(offsets[i - 1] + 3, offsets[i]);
+		}
+
+		// The next slot needs a second slab
+		offsets.push_back(slabs.Allocate(3));
+		EXPECT_EQ(2u, slabs.SlabsInUse());
+
+		// Other classes use their own slabs
+		auto one = slabs.Allocate(1);
+		auto five = slabs.Allocate(5);
+		EXPECT_EQ(4u, slabs.SlabsInUse());
+		EXPECT_EQ(0u, buddy.TotalFree());
+
+		unsigned int offset;
+		EXPECT_FALSE(slabs.TryAllocate(2, offset));
+		EXPECT_FALSE(slabs.TryAllocate(9, offset));
+
+		// Empty slabs go back to the buddy allocator
+		slabs.Free(one);
+		slabs.Free(five);
+		EXPECT_EQ(2u, slabs.SlabsInUse());
+		for (auto o : offsets)
+		{
+			slabs.Free(o);
+		}
+		EXPECT_EQ(0u, slabs.SlabsInUse());
+		EXPECT_EQ(256u, buddy.MaxAllocationSize());
+	}
+
+	TEST_F(SlabSuballocatorTest, RejectsInvalidFree)
+	{
+		TBuddySuballocator<unsigned int> buddy(128);
+		TSlabSuballocator<unsigned int> slabs(buddy, 32, { 3, 6 });
+
+		auto a = slabs.Allocate(2);
+		auto b = slabs.Allocate(2);
+		EXPECT_EQ(a + 3, b);
+
+		EXPECT_FALSE(slabs.TryFree(a + 1)); // Not a slot boundary
+		EXPECT_FALSE(slabs.TryFree(b + 3)); // Free slot
+		EXPECT_FALSE(slabs.TryFree(100));   // No slab
+		EXPECT_FALSE(slabs.TryFree(a + 30)); // Slab tail past the last slot
+		EXPECT_THROW(slabs.Free(b + 3), BuddySuballocatorException);
+
+		EXPECT_TRUE(slabs.TryFree(a));
+		EXPECT_FALSE(slabs.TryFree(a));
+		slabs.Free(b);
+		EXPECT_EQ(128u, buddy.TotalFree());
+	}
+
+	TEST_F(SlabSuballocatorTest, RejectsInvalidClasses)
+	{
+		TBuddySuballocator<unsigned int> buddy(256);
+		EXPECT_THROW(TSlabSuballocator<unsigned int>(buddy, 64, {}), std::invalid_argument);
+		EXPECT_THROW(TSlabSuballocator<unsigned int>(buddy, 64, { 2, 0 }), std::invalid_argument);
+
+		// A 128-unit slab would need 128 one-unit slots
+		EXPECT_THROW(TSlabSuballocator<unsigned int>(buddy, 128), std::invalid_argument);
+		TSlabSuballocator<unsigned int> slabs(buddy, 128, { 2, 3 });
+		EXPECT_EQ(128u, slabs.SlabSize());
+		EXPECT_EQ(256u, buddy.TotalFree());
+	}
+
+	TEST_F(SlabSuballocatorTest, ReleasesSlabsOnDestruction)
+	{
+		TBuddySuballocator<unsigned int> buddy(64);
+		{
+			TSlabSuballocator<unsigned int> slabs(buddy, 16);
+			slabs.Allocate(1);
+			slabs.Allocate(4);
+			EXPECT_EQ(32u, buddy.TotalFree());
+		}
+		EXPECT_EQ(64u, buddy.MaxAllocationSize());
+	}
+
+	class TlsfSuballocatorTest : public ::testing::Test
+	{
+	protected:
+		void SetUp() override {}
+		void TearDown() override {}
+	};
+
+	TEST_F(TlsfSuballocatorTest, AllocatesExactSizes)
+	{
+		TTlsfSuballocator<unsigned int> alloc(1000);
+		EXPECT_EQ(1000u, alloc.TotalFree());
+		EXPECT_EQ(1000u, alloc.MaxAllocationSize());
+
+		auto b0 = alloc.Allocate(100);
+		auto b1 = alloc.Allocate(3);
+		auto b2 = alloc.Allocate(257);
+		EXPECT_EQ(0u, b0.Start());
+		EXPECT_EQ(100u, b0.Size());
+		EXPECT_EQ(100u, b1.Start());
+		EXPECT_EQ(103u, b2.Start());
+		EXPECT_EQ(640u, alloc.TotalFree());
+		EXPECT_EQ(640u, alloc.MaxAllocationSize());
+
+		auto b3 = alloc.Allocate(512);
+		EXPECT_EQ(128u, alloc.TotalFree());
+
+		// Requests larger than the remaining space fail
+		TTlsfBlock<unsigned int> block;
+		EXPECT_FALSE(alloc.TryAllocate(129, block));
+
+		alloc.Free(b0);
+		alloc.Free(b1);
+		alloc.Free(b2);
+		alloc.Free(b3);
+		EXPECT_EQ(1000u, alloc.TotalFree());
+		EXPECT_EQ(1000u, alloc.MaxAllocationSize());
+	}
+
+	TEST_F(TlsfSuballocatorTest, CoalescesNeighbors)
+	{
+		TTlsfSuballocator<unsigned int> alloc(64);
+		std::vector<TTlsfBlock<unsigned int>> blocks;
+		for (int i = 0; i < 8; ++i)
+		{
+			blocks.push_back(alloc.Allocate(8));
+		}
+		EXPECT_EQ(0u, alloc.TotalFree());
+
+		// Free every other block: no coalescing possible
+		for (int i = 0; i < 8; i += 2)
+		{
+			alloc.Free(blocks[i]);
+		}
+		EXPECT_EQ(32u, alloc.TotalFree());
+		EXPECT_EQ(8u, alloc.MaxAllocationSize());
+
+		// Freeing the gaps merges with both neighbors
+		alloc.Free(blocks[1]);
+		EXPECT_EQ(24u, alloc.MaxAllocationSize());
+		alloc.Free(blocks[5]);
+		alloc.Free(blocks[3]);
+		EXPECT_EQ(56u, alloc.MaxAllocationSize());
+		alloc.Free(blocks[7]);
+		EXPECT_EQ(64u, alloc.MaxAllocationSize());
+	}
+
+	TEST_F(TlsfSuballocatorTest, RejectsInvalidFree)
+	{
+		TTlsfSuballocator<unsigned int> alloc(32);
+		auto b = alloc.Allocate(5);
+
+		EXPECT_FALSE(alloc.TryFree(TTlsfBlock<unsigned int>(b.Start(), 4)));
+		EXPECT_FALSE(alloc.TryFree(TTlsfBlock<unsigned int>(5, 5)));
+		EXPECT_FALSE(alloc.TryFree(TTlsfBlock<unsigned int>(64, 1)));
+		EXPECT_TRUE(alloc.TryFree(b));
+
+		bool exceptionHit = false;
+		try
+		{
+			alloc.Free(b);
+		}
+		catch (TlsfSuballocatorException& e)
+		{
+			exceptionHit = e.T == TlsfSuballocatorException::Type::NotAllocated;
+		}
+		EXPECT_TRUE(exceptionHit);
+	}
+
+	TEST_F(TlsfSuballocatorTest, GrowExtendsLastFreeBlock)
+	{
+		TTlsfSuballocator<unsigned int> alloc(48);
+		auto b0 = alloc.Allocate(40);
+		TTlsfBlock<unsigned int> block;
+		EXPECT_FALSE(alloc.TryAllocate(20, block));
+
+		alloc.Grow();
+		EXPECT_EQ(96u, alloc.GetCapacity());
+		EXPECT_EQ(56u, alloc.TotalFree());
+		EXPECT_EQ(56u, alloc.MaxAllocationSize());
+
+		auto b1 = alloc.Allocate(50);
+		EXPECT_EQ(40u, b1.Start());
+
+		alloc.Free(b0);
+		alloc.Free(b1);
+		EXPECT_EQ(96u, alloc.MaxAllocationSize());
+
+		// Capacity limited by the index type
+		TTlsfSuballocator<unsigned char> small(200);
+		EXPECT_THROW(small.Grow(), TlsfSuballocatorException);
+	}
+
+	class PoolSuballocatorTest : public ::testing::Test
+	{
+	protected:
+		void SetUp() override {}
+		void TearDown() override {}
+	};
+
+	TEST_F(PoolSuballocatorTest, AllocateAndFreeSlots)
+	{
+		TPoolSuballocator<unsigned int> pool(4, 16);
+		EXPECT_EQ(4u, pool.FreeCount());
+
+		EXPECT_EQ(0u, pool.Allocate());
+		EXPECT_EQ(16u, pool.Allocate());
+		EXPECT_EQ(32u, pool.Allocate());
+		EXPECT_EQ(48u, pool.Allocate());
+		EXPECT_EQ(0u, pool.FreeCount());
+		EXPECT_THROW(pool.Allocate(), std::bad_alloc);
+
+		unsigned int offset;
+		EXPECT_FALSE(pool.TryAllocate(offset));
+
+		// Most recently freed slot is reused first
+		pool.Free(16);
+		EXPECT_TRUE(pool.TryAllocate(offset));
+		EXPECT_EQ(16u, offset);
+
+		// Invalid frees
+		EXPECT_FALSE(pool.TryFree(8));   // Not a slot boundary
+		EXPECT_FALSE(pool.TryFree(64));  // Out of range
+		pool.Free(32);
+		EXPECT_FALSE(pool.TryFree(32));  // Already free
+		EXPECT_THROW(pool.Free(32), std::invalid_argument);
+		EXPECT_EQ(3u, pool.AllocatedCount());
+	}
+
+	TEST_F(PoolSuballocatorTest, BatchOperations)
+	{
+		TPoolSuballocator<unsigned short> pool(8);
+		unsigned short offsets[8];
+
+		pool.AllocateBatch(6, offsets);
+		EXPECT_EQ(2u, pool.FreeCount());
+		EXPECT_THROW(pool.AllocateBatch(3, offsets + 6), std::bad_alloc);
+		EXPECT_EQ(2u, pool.FreeCount());
+
+		// Duplicate offsets reject the whole batch
+		unsigned short duplicate[] = { offsets[0], offsets[1], offsets[0] };
+		EXPECT_THROW(pool.FreeBatch(duplicate, 3), std::invalid_argument);
+		EXPECT_EQ(6u, pool.AllocatedCount());
+		EXPECT_TRUE(pool.IsAllocated(offsets[0]));
+		EXPECT_TRUE(pool.IsAllocated(offsets[1]));
+
+		pool.FreeBatch(offsets, 6);
+		EXPECT_EQ(8u, pool.FreeCount());
+	}
+
+	TEST_F(PoolSuballocatorTest, GrowKeepsExistingSlots)
+	{
+		TPoolSuballocator<unsigned int> pool(2, 4);
+		auto a = pool.Allocate();
+		auto b = pool.Allocate();
+
+		pool.Grow();
+		EXPECT_EQ(4u, pool.SlotCount());
+		EXPECT_EQ(2u, pool.FreeCount());
+		EXPECT_TRUE(pool.IsAllocated(a));
+		EXPECT_TRUE(pool.IsAllocated(b));
+
+		EXPECT_EQ(8u, pool.Allocate());
+		EXPECT_EQ(12u, pool.Allocate());
+		pool.Free(a);
+		pool.Free(b);
+		EXPECT_EQ(2u, pool.FreeCount());
+
+		// Offsets must fit the index type
+		TPoolSuballocator<unsigned char> small(128, 2);
+		EXPECT_THROW(small.Grow(), std::bad_alloc);
+	}
+
+	class LinearSuballocatorTest : public ::testing::Test
+	{
+	protected:
+		void SetUp() override {}
+		void TearDown() override {}
+	};
+
+	TEST_F(LinearSuballocatorTest, AllocateWithAlignment)
+	{
+		TLinearSuballocator<unsigned int> alloc(64);
+
+		EXPECT_EQ(0u, alloc.Allocate(3));
+		EXPECT_EQ(3u, alloc.Allocate(1));
+		EXPECT_EQ(8u, alloc.Allocate(4, 8));
+		EXPECT_EQ(12u, alloc.AllocatedSize());
+		EXPECT_EQ(16u, alloc.Allocate(16, 16));
+		EXPECT_EQ(32u, alloc.FreeSize());
+
+		EXPECT_THROW(alloc.Allocate(1, 128), std::bad_alloc);
+		EXPECT_THROW(alloc.Allocate(33), std::bad_alloc);
+		unsigned int offset;
+		EXPECT_TRUE(alloc.TryAllocate(32, 1, offset));
+		EXPECT_EQ(32u, offset);
+		EXPECT_FALSE(alloc.TryAllocate(1, 1, offset));
+
+		alloc.Reset();
+		EXPECT_EQ(64u, alloc.FreeSize());
+		EXPECT_EQ(0u, alloc.Allocate(1));
+	}
+
+	TEST_F(LinearSuballocatorTest, MarkersRollBack)
+	{
+		TLinearSuballocator<unsigned int> alloc(100, 1000);
+
+		EXPECT_EQ(1000u, alloc.Allocate(10));
+		auto marker = alloc.GetMarker();
+		alloc.Allocate(20);
+		auto inner = alloc.GetMarker();
+		alloc.Allocate(30);
+		EXPECT_EQ(60u, alloc.AllocatedSize());
+
+		alloc.RollbackTo(inner);
+		EXPECT_EQ(30u, alloc.AllocatedSize());
+		alloc.RollbackTo(marker);
+		EXPECT_EQ(10u, alloc.AllocatedSize());
+		EXPECT_EQ(1010u, alloc.Allocate(5));
+
+		// Alignment applies to the absolute offset
+		EXPECT_EQ(1016u, alloc.Allocate(1, 8));
+
+		// Rolling forward is not allowed
+		EXPECT_THROW(alloc.RollbackTo(inner), std::invalid_argument);
+	}
+
+	TEST_F(LinearSuballocatorTest, DoubleBufferedFrames)
+	{
+		TDoubleBufferedLinearSuballocator<unsigned int> alloc(32);
+
+		EXPECT_EQ(0u, alloc.Allocate(16));
+		EXPECT_EQ(0u, alloc.CurrentFrameIndex());
+
+		alloc.NextFrame();
+		EXPECT_EQ(1u, alloc.CurrentFrameIndex());
+		EXPECT_EQ(32u, alloc.Allocate(8));
+		EXPECT_EQ(40u, alloc.Allocate(8));
+
+		// Returning to frame 0 releases only its allocations
+		alloc.NextFrame();
+		EXPECT_EQ(0u, alloc.Allocate(32));
+		alloc.NextFrame();
+		EXPECT_EQ(32u, alloc.Allocate(1));
+
+		alloc.Reset();
+		EXPECT_EQ(0u, alloc.CurrentFrameIndex());
+		EXPECT_EQ(32u, alloc.CurrentFrame().FreeSize());
+	}
+
+	class ComposableSuballocatorTest : public ::testing::Test
+	{
+	protected:
+		void SetUp() final {}
+		void TearDown() final {}
+	};
+
+	TEST_F(ComposableSuballocatorTest, SegregatorRoutesBySize)
+	{
+		using Heap = TSegregator<4, TPoolSuballocatorAdapter<unsigned int>,
+			TSegregator<64, TBuddySuballocatorAdapter<unsigned int>, TTlsfSuballocatorAdapter<unsigned int>>>;
+		static_assert(IsComposableSuballocator<Heap>::value, "Heap must be composable");
+		static_assert(!IsComposableSuballocator<TBuddySuballocator<unsigned int>>::value, "Raw allocators are not composable");
+
+		Heap heap(TPoolSuballocatorAdapter<unsigned int>(4, 4, 0),
+			{ TBuddySuballocatorAdapter<unsigned int>(256, 16), TTlsfSuballocatorAdapter<unsigned int>(1024, 272) });
+
+		TSuballocation<unsigned int> tiny, mid, large;
+		EXPECT_TRUE(heap.TryAllocate(3, tiny));
+		EXPECT_EQ(0u, tiny.Offset);
+		EXPECT_TRUE(heap.TryAllocate(20, mid));
+		EXPECT_EQ(16u, mid.Offset);
+		EXPECT_TRUE(heap.TryAllocate(100, large));
+		EXPECT_EQ(272u, large.Offset);
+
+		EXPECT_TRUE(heap.Owns(tiny));
+		EXPECT_TRUE(heap.Owns(mid));
+		EXPECT_TRUE(heap.Owns(large));
+		EXPECT_EQ(3u, heap.Small().Get().FreeCount());
+		EXPECT_EQ(1024u - 100u, heap.Large().Large().Get().TotalFree());
+
+		// Requests too large for every tier fail without throwing
+		TSuballocation<unsigned int> none;
+		EXPECT_FALSE(heap.TryAllocate(2048, none));
+
+		heap.Free(tiny);
+		heap.Free(mid);
+		heap.Free(large);
+		EXPECT_EQ(4u, heap.Small().Get().FreeCount());
+		EXPECT_EQ(256u, heap.Large().Small().Get().TotalFree());
+		EXPECT_EQ(1024u, heap.Large().Large().Get().TotalFree());
+	}
+
+	TEST_F(ComposableSuballocatorTest, FallbackUsesSecondaryWhenFull)
+	{
+		TFallback<TPoolSuballocatorAdapter<unsigned int>, TBuddySuballocatorAdapter<unsigned int>> alloc(
+			TPoolSuballocatorAdapter<unsigned int>(2, 8, 0),
+			TBuddySuballocatorAdapter<unsigned int>(64, 16));
+
+		TSuballocation<unsigned int> a, b, c, d;
+		EXPECT_TRUE(alloc.TryAllocate(8, a));
+		EXPECT_TRUE(alloc.TryAllocate(8, b));
+		EXPECT_TRUE(alloc.TryAllocate(8, c));
+		EXPECT_EQ(0u, a.Offset);
+		EXPECT_EQ(8u, b.Offset);
+		EXPECT_EQ(16u, c.Offset);
+
+		// Sizes the pool cannot serve go straight to the buddy allocator
+		EXPECT_TRUE(alloc.TryAllocate(32, d));
+		EXPECT_EQ(48u, d.Offset);
+
+		EXPECT_TRUE(alloc.Primary().Owns(b));
+		EXPECT_FALSE(alloc.Primary().Owns(c));
+		alloc.Free(c);
+		alloc.Free(b);
+		alloc.Free(d);
+		EXPECT_EQ(1u, alloc.Primary().Get().FreeCount());
+		EXPECT_EQ(64u, alloc.Secondary().Get().TotalFree());
+
+		EXPECT_TRUE(alloc.TryAllocate(4, b));
+		EXPECT_EQ(8u, b.Offset);
+	}
+
+	TEST_F(ComposableSuballocatorTest, BucketizerSplitsSizeRange)
+	{
+		using Bucket = TPoolSuballocatorAdapter<unsigned int>;
+		TBucketizer<Bucket, 0, 32, 8> alloc([](size_t index, size_t maxSize)
+		{
+			return Bucket(4, maxSize, (unsigned int) (index * 256));
+		});
+		EXPECT_EQ(4u, (TBucketizer<Bucket, 0, 32, 8>::BucketCount));
+
+		TSuballocation<unsigned int> a, b, c;
+		EXPECT_TRUE(alloc.TryAllocate(1, a));
+		EXPECT_EQ(0u, a.Offset);
+		EXPECT_TRUE(alloc.TryAllocate(9, b));
+		EXPECT_EQ(256u, b.Offset);
+		EXPECT_TRUE(alloc.TryAllocate(32, c));
+		EXPECT_EQ(768u, c.Offset);
+		EXPECT_EQ(32u, alloc.Bucket(3).Get().SlotSize());
+
+		TSuballocation<unsigned int> none;
+		EXPECT_FALSE(alloc.TryAllocate(0, none));
+		EXPECT_FALSE(alloc.TryAllocate(33, none));
+
+		EXPECT_TRUE(alloc.Owns(b));
+		alloc.Free(b);
+		EXPECT_EQ(4u, alloc.Bucket(1).Get().FreeCount());
+		alloc.Free(a);
+		alloc.Free(c);
+
+		// Foreign allocations outside the size range are rejected
+		TSuballocation<unsigned int> foreign;
+		foreign.Offset = 0;
+		foreign.Size = 0;
+		EXPECT_THROW(alloc.Free(foreign), std::invalid_argument);
+		foreign.Size = 33;
+		EXPECT_THROW(alloc.Free(foreign), std::invalid_argument);
+	}
+
+	TEST_F(ComposableSuballocatorTest, RingAdapterRejectsOutOfOrderFree)
+	{
+		TRingSuballocatorAdapter<unsigned int> ring(100, 1000);
+		TSuballocation<unsigned int> a, b, c;
+		ASSERT_TRUE(ring.TryAllocate(60, a));
+		ASSERT_TRUE(ring.TryAllocate(30, b));
+		EXPECT_THROW(ring.Free(b), std::invalid_argument);
+		ring.Free(a);
+
+		// c skips the 10-unit tail and starts over at the base offset
+		ASSERT_TRUE(ring.TryAllocate(50, c));
+		EXPECT_EQ(1000u, c.Offset);
+		EXPECT_THROW(ring.Free(c), std::invalid_argument);
+		ring.Free(b);
+		ring.Free(c);
+		EXPECT_EQ(100u, ring.Get().FreeSize());
+		EXPECT_THROW(ring.Free(c), std::invalid_argument);
+	}
+
+	class ConcurrentRingSuballocatorTest : public ::testing::Test
+	{
+	protected:
+		void SetUp() override {}
+		void TearDown() override {}
+	};
+
+	TEST_F(ConcurrentRingSuballocatorTest, FreeStopsAtUncommitted)
+	{
+		TConcurrentRingSuballocator<unsigned int> Allocator(100);
+
+		auto A = Allocator.Reserve(10);
+		auto B = Allocator.Reserve(20);
+		auto C = Allocator.Reserve(30);
+		EXPECT_EQ(0u, A.Offset);
+		EXPECT_EQ(10u, B.Offset);
+		EXPECT_EQ(30u, C.Offset);
+		EXPECT_EQ(40u, Allocator.FreeSize());
+
+		// Committing out of order publishes nothing until the oldest reservation is committed
+		Allocator.Commit(B);
+		Allocator.Commit(C);
+		EXPECT_EQ(0u, Allocator.CommittedSize());
+		EXPECT_EQ(0u, Allocator.Free(60));
+
+		Allocator.Commit(A);
+		EXPECT_EQ(60u, Allocator.CommittedSize());
+		EXPECT_EQ(15u, Allocator.Free(15));
+		EXPECT_EQ(45u, Allocator.CommittedSize());
+		EXPECT_EQ(45u, Allocator.Free(100));
+		EXPECT_EQ(100u, Allocator.FreeSize());
+
+		TRingReservation<unsigned int> D;
+		EXPECT_FALSE(Allocator.TryReserve(101, 1, D));
+	}
+
+	TEST_F(ConcurrentRingSuballocatorTest, ContiguousPaddingIsReclaimed)
+	{
+		TConcurrentRingSuballocator<unsigned int> Allocator(64, true);
+
+		auto A = Allocator.Reserve(40);
+		auto B = Allocator.Reserve(8, 16);
+		EXPECT_EQ(48u, B.Offset);
+		Allocator.Commit(A);
+		Allocator.Commit(B);
+		EXPECT_EQ(40u, Allocator.Free(40));
+
+		// The 8 unit tail is skipped
+		auto C = Allocator.Reserve(30);
+		EXPECT_EQ(0u, C.Offset);
+		EXPECT_THROW(Allocator.Reserve(20), std::bad_alloc);
+		Allocator.Commit(C);
+		EXPECT_EQ(38u, Allocator.CommittedSize());
+		EXPECT_EQ(38u, Allocator.Free(38));
+		EXPECT_EQ(0u, Allocator.AllocatedSize());
+	}
+
+	TEST_F(ConcurrentRingSuballocatorTest, ConcurrentProducers)
+	{
+		constexpr size_t NumProducers = 4;
+		constexpr size_t NumReservations = 2000;
+		TConcurrentRingSuballocator<unsigned int> Allocator(256, true);
+		std::vector<std::atomic<int>> Owners(256);
+		std::atomic<bool> Overlap{ false };
+
+		std::vector<std::thread> Producers;
+		for (size_t p = 0; p < NumProducers; ++p)
+		{
+			Producers.emplace_back([&, p]()
+			{
+				for (size_t i = 0; i < NumReservations; ++i)
+				{
+					size_t Size = 1 + (i + p) % 7;
+					TRingReservation<unsigned int> Reservation;
+					while (!Allocator.TryReserve(Size, 1, Reservation))
+						std::this_thread::yield();
+
+					// No other live reservation may cover these units
+					for (size_t u = 0; u < Size; ++u)
+						if (Owners[Reservation.Offset + u].exchange(int(p) + 1) != 0)
+							Overlap = true;
+					for (size_t u = 0; u < Size; ++u)
+						Owners[Reservation.Offset + u] = 0;
+
+					Allocator.Commit(Reservation);
+				}
+			});
+		}
+
+		size_t Expected = 0;
+		for (size_t p = 0; p < NumProducers; ++p)
+			for (size_t i = 0; i < NumReservations; ++i)
+				Expected += 1 + (i + p) % 7;
+
+		size_t Freed = 0;
+		while (Freed < Expected)
+		{
+			Freed += Allocator.Free(Expected - Freed);
+		}
+
+		for (auto& Producer : Producers)
+			Producer.join();
+
+		EXPECT_FALSE(Overlap);
+		EXPECT_EQ(Expected, Freed);
+		EXPECT_EQ(0u, Allocator.AllocatedSize());
+	}
+
+	class SpscByteChannelTest : public ::testing::Test
+	{
+	protected:
+		void SetUp() override {}
+		void TearDown() override {}
+	};
+
+	TEST_F(SpscByteChannelTest, RecordsWrapAround)
+	{
+		alignas(8) uint8_t Buffer[64];
+		TSpscByteChannel<uint32_t> Channel(Buffer, sizeof(Buffer));
+		EXPECT_EQ(56u, Channel.MaxRecordSize());
+
+		// Records are not visible until published
+		auto Span = Channel.BeginWrite(5);
+		ASSERT_NE(nullptr, Span.Data);
+		memcpy(Span.Data, "hello", 5);
+		Channel.EndWrite();
+		EXPECT_EQ(nullptr, Channel.PeekRead().Data);
+		Channel.Publish();
+
+		Span = Channel.PeekRead();
+		ASSERT_EQ(5u, Span.Size);
+		EXPECT_EQ(0, memcmp(Span.Data, "hello", 5));
+		EXPECT_EQ(Buffer + 8, Span.Data);
+
+		// Fill the buffer, leaving an 8 byte tail
+		Span = Channel.BeginWrite(8);
+		ASSERT_NE(nullptr, Span.Data);
+		Channel.EndWrite();
+		Span = Channel.BeginWrite(16);
+		ASSERT_NE(nullptr, Span.Data);
+		Channel.EndWrite();
+		EXPECT_EQ(nullptr, Channel.BeginWrite(1).Data);
+
+		// Consuming the first record frees space, and the next record wraps to the start
+		Channel.ConsumeRead();
+		Span = Channel.BeginWrite(7);
+		EXPECT_EQ(Buffer + 8, Span.Data);
+		memcpy(Span.Data, "wrapped", 7);
+		Channel.EndWrite();
+		Channel.Publish();
+
+		EXPECT_EQ(8u, Channel.PeekRead().Size);
+		Channel.ConsumeRead();
+		EXPECT_EQ(16u, Channel.PeekRead().Size);
+		Channel.ConsumeRead();
+		Span = Channel.PeekRead();
+		ASSERT_EQ(7u, Span.Size);
+		EXPECT_EQ(0, memcmp(Span.Data, "wrapped", 7));
+		Channel.ConsumeRead();
+		EXPECT_EQ(nullptr, Channel.PeekRead().Data);
+
+		// A full-size record must wait for the consumer to follow the wrap marker
+		EXPECT_EQ(nullptr, Channel.BeginWrite(57).Data);
+		EXPECT_EQ(nullptr, Channel.BeginWrite(56).Data);
+		Channel.Publish();
+		EXPECT_EQ(nullptr, Channel.PeekRead().Data);
+		Span = Channel.BeginWrite(56);
+		EXPECT_EQ(Buffer + 8, Span.Data);
+	}
+
+	TEST_F(SpscByteChannelTest, CancelledRecordsAreSkipped)
+	{
+		alignas(8) uint8_t Buffer[64];
+		TSpscByteChannel<uint32_t> Channel(Buffer, sizeof(Buffer));
+
+		auto Span = Channel.BeginWrite(5);
+		memcpy(Span.Data, "first", 5);
+		Channel.EndWrite();
+
+		// Only one record can be in progress
+		ASSERT_NE(nullptr, Channel.BeginWrite(8).Data);
+		EXPECT_THROW(Channel.BeginWrite(1), std::logic_error);
+		Channel.CancelWrite();
+
+		Span = Channel.BeginWrite(4);
+		memcpy(Span.Data, "last", 4);
+		Channel.EndWrite();
+		Channel.Publish();
+
+		Span = Channel.PeekRead();
+		ASSERT_EQ(5u, Span.Size);
+		EXPECT_EQ(0, memcmp(Span.Data, "first", 5));
+		Channel.ConsumeRead();
+		Span = Channel.PeekRead();
+		ASSERT_EQ(4u, Span.Size);
+		EXPECT_EQ(0, memcmp(Span.Data, "last", 4));
+		Channel.ConsumeRead();
+		EXPECT_EQ(nullptr, Channel.PeekRead().Data);
+
+		// Cancelled space is reclaimed, including across wrap markers
+		for (int i = 0; i < 20; ++i)
+		{
+			ASSERT_NE(nullptr, Channel.BeginWrite(20).Data);
+			Channel.CancelWrite();
+			Channel.Publish();
+			EXPECT_EQ(nullptr, Channel.PeekRead().Data);
+		}
+	}
+
+	TEST_F(SpscByteChannelTest, ProducerAndConsumerThreads)
+	{
+		constexpr uint32_t NumRecords = 20000;
+		alignas(8) static uint8_t Buffer[1024];
+		TSpscByteChannel<uint32_t> Channel(Buffer, sizeof(Buffer));
+
+		std::thread Producer([&]()
+		{
+			for (uint32_t i = 0; i < NumRecords; ++i)
+			{
+				size_t Size = sizeof(uint32_t) + i % 61;
+				ByteSpan Span;
+				while (!(Span = Channel.BeginWrite(Size)).Data)
+				{
+					Channel.Publish();
+					std::this_thread::yield();
+				}
+
+				memcpy(Span.Data, &i, sizeof(i));
+				memset(Span.Data + sizeof(i), int(i & 0xff), Size - sizeof(i));
+				Channel.EndWrite();
+				if (i % 8 == 7)
+					Channel.Publish();
+			}
+			Channel.Publish();
+		});
+
+		bool Valid = true;
+		for (uint32_t i = 0; i < NumRecords; ++i)
+		{
+			ByteSpan Span;
+			while (!(Span = Channel.PeekRead()).Data)
+				std::this_thread::yield();
+
+			uint32_t Value;
+			memcpy(&Value, Span.Data, sizeof(Value));
+			Valid = Valid && Value == i && Span.Size == sizeof(uint32_t) + i % 61;
+			for (size_t b = sizeof(Value); b < Span.Size; ++b)
+				Valid = Valid && Span.Data[b] == uint8_t(i & 0xff);
+			Channel.ConsumeRead();
+		}
+
+		Producer.join();
+		EXPECT_TRUE(Valid);
+		EXPECT_EQ(nullptr, Channel.PeekRead().Data);
+	}
+
+	class FileStagingPipelineTest : public ::testing::Test
+	{
+	protected:
+		void SetUp() override {}
+		void TearDown() override {}
+	};
+
+	TEST_F(FileStagingPipelineTest, StreamsFileThroughSmallBuffer)
+	{
+		const char* Path = "FileStagingPipelineTest.tmp";
+		std::vector<uint8_t> Contents(100000);
+		for (size_t i = 0; i < Contents.size(); ++i)
+			Contents[i] = uint8_t((i * 7) ^ (i >> 8));
+
+		FILE* pFile = fopen(Path, "wb");
+		ASSERT_NE(nullptr, pFile);
+		fwrite(Contents.data(), 1, Contents.size(), pFile);
+		fclose(pFile);
+
+		alignas(8) static uint8_t Buffer[8192];
+		TFileStagingPipeline<uint32_t> Pipeline(Buffer, sizeof(Buffer), 3000);
+		EXPECT_EQ(3000u, Pipeline.ChunkSize());
+
+		for (auto Mode : { StagingReadMode::Read, StagingReadMode::MemoryMap })
+		{
+			ASSERT_TRUE(Pipeline.Start(Path, Mode));
+
+			std::vector<uint8_t> Staged;
+			StagedChunk Chunk;
+			bool InOrder = true;
+			while (Pipeline.AcquireChunk(Chunk))
+			{
+				InOrder = InOrder && Chunk.FileOffset == Staged.size();
+				EXPECT_GE(Chunk.Data, Buffer);
+				EXPECT_LE(Chunk.Data + Chunk.Size, Buffer + sizeof(Buffer));
+				Staged.insert(Staged.end(), Chunk.Data, Chunk.Data + Chunk.Size);
+				Pipeline.ReleaseChunk();
+			}
+
+			EXPECT_TRUE(InOrder);
+			EXPECT_FALSE(Pipeline.Failed());
+			EXPECT_TRUE(Staged == Contents);
+			Pipeline.Stop();
+		}
+
+		remove(Path);
+		EXPECT_FALSE(Pipeline.Start(Path));
+	}
+
+	TEST_F(FileStagingPipelineTest, ShrunkFileFailsAndRestarts)
+	{
+		alignas(8) static uint8_t Tiny[24];
+		EXPECT_THROW(TFileStagingPipeline<uint32_t>(Tiny, sizeof(Tiny)), std::invalid_argument);
+
+		const char* Path = "FileStagingPipelineShrinkTest.tmp";
+		std::vector<uint8_t> Contents(100000);
+		for (size_t i = 0; i < Contents.size(); ++i)
+			Contents[i] = uint8_t(i * 13);
+
+		FILE* pFile = fopen(Path, "wb");
+		ASSERT_NE(nullptr, pFile);
+		fwrite(Contents.data(), 1, Contents.size(), pFile);
+		fclose(pFile);
+
+		alignas(8) static uint8_t Buffer[8192];
+		TFileStagingPipeline<uint32_t> Pipeline(Buffer, sizeof(Buffer), 3000);
+		ASSERT_TRUE(Pipeline.Start(Path));
+
+		// The reader can't get far before the buffer fills, so it runs past the truncated end
+		pFile = fopen(Path, "wb");
+		ASSERT_NE(nullptr, pFile);
+		fwrite(Contents.data(), 1, 1000, pFile);
+		fclose(pFile);
+
+		StagedChunk Chunk;
+		while (Pipeline.AcquireChunk(Chunk))
+			Pipeline.ReleaseChunk();
+		EXPECT_TRUE(Pipeline.Failed());
+
+		// The failed chunk's reservation must not leave a bogus record ahead of the next stream
+		pFile = fopen(Path, "wb");
+		ASSERT_NE(nullptr, pFile);
+		fwrite(Contents.data(), 1, Contents.size(), pFile);
+		fclose(pFile);
+
+		ASSERT_TRUE(Pipeline.Start(Path));
+		std::vector<uint8_t> Staged;
+		while (Pipeline.AcquireChunk(Chunk))
+		{
+			EXPECT_EQ(Staged.size(), Chunk.FileOffset);
+			Staged.insert(Staged.end(), Chunk.Data, Chunk.Data + Chunk.Size);
+			Pipeline.ReleaseChunk();
+		}
+		EXPECT_FALSE(Pipeline.Failed());
+		EXPECT_TRUE(Staged == Contents);
+		Pipeline.Stop();
+		remove(Path);
+	}
+
+	class AsyncSuballocatorTest : public ::testing::Test
+	{
+	protected:
+		void SetUp() final {}
+		void TearDown() final {}
+	};
+
+	// Waits until the given number of requests are queued
+	template<class _Heap>
+	void WaitForWaiters(const _Heap& heap, size_t count)
+	{
+		while (heap.WaiterCount() != count)
+			std::this_thread::yield();
+	}
+
+	TEST_F(AsyncSuballocatorTest, BlockedThreadResumesOnFree)
+	{
+		TAsyncSuballocator<TBuddySuballocatorAdapter<unsigned int>> heap(TBuddySuballocatorAdapter<unsigned int>(64));
+		auto full = heap.Allocate(64);
+
+		TSuballocation<unsigned int> granted;
+		std::thread waiter([&] { granted = heap.Allocate(32); });
+		WaitForWaiters(heap, 1);
+
+		// Fifo order keeps new requests behind the waiter
+		TSuballocation<unsigned int> out;
+		EXPECT_FALSE(heap.TryAllocate(1, out));
+
+		heap.Free(full);
+		waiter.join();
+		EXPECT_EQ(0u, heap.WaiterCount());
+		EXPECT_EQ(32u, granted.Size);
+		EXPECT_TRUE(heap.TryAllocate(32, out));
+		EXPECT_NE(granted.Offset, out.Offset);
+	}
+
+	TEST_F(AsyncSuballocatorTest, WaitOrder)
+	{
+		for (auto order : { AsyncWaitOrder::Fifo, AsyncWaitOrder::FirstFit })
+		{
+			TAsyncSuballocator<TBuddySuballocatorAdapter<unsigned int>> heap(TBuddySuballocatorAdapter<unsigned int>(64), order);
+			auto a = heap.Allocate(32);
+			auto b = heap.Allocate(16);
+			auto c = heap.Allocate(16);
+
+			std::thread large([&] { heap.Free(heap.Allocate(64)); });
+			WaitForWaiters(heap, 1);
+			std::thread small([&] { heap.Free(heap.Allocate(8)); });
+			WaitForWaiters(heap, 2);
+
+			// Only the small request fits, so it is granted only in FirstFit order
+			heap.Free(b);
+			if (order == AsyncWaitOrder::FirstFit)
+			{
+				small.join();
+				EXPECT_EQ(1u, heap.WaiterCount());
+			}
+			else
+			{
+				EXPECT_EQ(2u, heap.WaiterCount());
+			}
+
+			heap.Free(a);
+			heap.Free(c);
+			large.join();
+			if (order == AsyncWaitOrder::Fifo)
+				small.join();
+			EXPECT_EQ(0u, heap.WaiterCount());
+		}
+	}
+
+	TEST_F(AsyncSuballocatorTest, TimedWait)
+	{
+		TAsyncSuballocator<TRingSuballocatorAdapter<unsigned int>> heap(TRingSuballocatorAdapter<unsigned int>(100));
+		auto first = heap.Allocate(60);
+		auto second = heap.Allocate(40);
+
+		TSuballocation<unsigned int> out;
+		EXPECT_FALSE(heap.TryAllocateFor(10, std::chrono::milliseconds(10), out));
+		EXPECT_EQ(0u, heap.WaiterCount());
+
+		// Ring allocations are freed oldest first
+		std::thread waiter([&] { EXPECT_TRUE(heap.TryAllocateFor(50, std::chrono::seconds(30), out)); });
+		WaitForWaiters(heap, 1);
+		heap.Free(first);
+		waiter.join();
+		EXPECT_EQ(0u, out.Offset);
+		heap.Free(second);
+		heap.Free(out);
+	}
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+	// Coroutine that starts eagerly and runs to completion without a result
+	struct FireAndForget
+	{
+		struct promise_type
+		{
+			FireAndForget get_return_object() { return {}; }
+			std::suspend_never initial_suspend() noexcept { return {}; }
+			std::suspend_never final_suspend() noexcept { return {}; }
+			void return_void() {}
+			void unhandled_exception() { std::terminate(); }
+		};
+	};
+
+	template<class _Heap>
+	FireAndForget AllocateAndRecord(_Heap& heap, size_t size, std::vector<TSuballocation<unsigned int>>& results)
+	{
+		results.push_back(co_await heap.AllocateAsync(size));
+	}
+
+	TEST_F(AsyncSuballocatorTest, CoroutinesResumeInOrder)
+	{
+		TAsyncSuballocator<TBuddySuballocatorAdapter<unsigned int>> heap(TBuddySuballocatorAdapter<unsigned int>(64));
+		std::vector<TSuballocation<unsigned int>> results;
+
+		// Completes without suspending
+		AllocateAndRecord(heap, 64, results);
+		ASSERT_EQ(1u, results.size());
+
+		AllocateAndRecord(heap, 32, results);
+		AllocateAndRecord(heap, 16, results);
+		AllocateAndRecord(heap, 16, results);
+		EXPECT_EQ(1u, results.size());
+		EXPECT_EQ(3u, heap.WaiterCount());
+
+		// Free resumes the waiters in arrival order on this thread
+		heap.Free(results[0]);
+		ASSERT_EQ(4u, results.size());
+		EXPECT_EQ(32u, results[1].Size);
+		EXPECT_EQ(16u, results[2].Size);
+		EXPECT_EQ(16u, results[3].Size);
+		EXPECT_EQ(0u, heap.WaiterCount());
+	}
+#endif
+
+	class QuadtreeSuballocatorTest : public ::testing::Test
+	{
+	protected:
+		void SetUp() final {}
+		void TearDown() final {}
+	};
+
+	TEST_F(QuadtreeSuballocatorTest, MortonCodes)
+	{
+		EXPECT_EQ(0u, MortonEncode2D(0, 0));
+		EXPECT_EQ(1u, MortonEncode2D(1, 0));
+		EXPECT_EQ(2u, MortonEncode2D(0, 1));
+		EXPECT_EQ(12u, MortonEncode2D(2, 2));
+		EXPECT_EQ(0xffffffffffffffffull, MortonEncode2D(0xffffffff, 0xffffffff));
+
+		uint32_t x, y;
+		MortonDecode2D(MortonEncode2D(12345, 54321), x, y);
+		EXPECT_EQ(12345u, x);
+		EXPECT_EQ(54321u, y);
+	}
+
+	TEST_F(QuadtreeSuballocatorTest, AllocateAndCoalesce)
+	{
+		TQuadtreeSuballocator<uint8_t> suballocator(8);
+		EXPECT_EQ(8u, suballocator.GetSide());
+		EXPECT_EQ(64u, suballocator.TotalFreeArea());
+
+		// Quadrants are allocated in Z order
+		auto a = suballocator.Allocate(4, 3);
+		auto b = suballocator.Allocate(4, 4);
+		auto c = suballocator.Allocate(2, 4);
+		EXPECT_EQ(TQuadBlock<uint8_t>(0, 0, 2), a);
+		EXPECT_EQ(TQuadBlock<uint8_t>(4, 0, 2), b);
+		EXPECT_EQ(TQuadBlock<uint8_t>(0, 4, 2), c);
+		EXPECT_EQ(16u, suballocator.TotalFreeArea());
+		EXPECT_EQ(4u, suballocator.MaxAllocationSide());
+
+		TQuadBlock<uint8_t> block;
+		EXPECT_FALSE(suballocator.TryAllocate(5, 1, block));
+
+		// Fill the last quadrant with single units
+		std::vector<TQuadBlock<uint8_t>> units;
+		while (suballocator.TryAllocate(1, 1, block))
+			units.push_back(block);
+		EXPECT_EQ(16u, units.size());
+		EXPECT_EQ(TQuadBlock<uint8_t>(4, 4, 0), units.front());
+		EXPECT_EQ(TQuadBlock<uint8_t>(7, 7, 0), units.back());
+		EXPECT_EQ(0u, suballocator.TotalFreeArea());
+		EXPECT_EQ(0u, suballocator.MaxAllocationSide());
+
+		EXPECT_THROW(suballocator.Free(TQuadBlock<uint8_t>(4, 4, 1)), BuddySuballocatorException);
+		EXPECT_THROW(suballocator.Free(TQuadBlock<uint8_t>(8, 0, 0)), BuddySuballocatorException);
+
+		for (auto& unit : units)
+			suballocator.Free(unit);
+		EXPECT_EQ(1u, suballocator.FreeBlockCount(2));
+		EXPECT_TRUE(suballocator.IsBlockFree(TQuadBlock<uint8_t>(4, 4, 2)));
+
+		suballocator.Free(b);
+		suballocator.Free(a);
+		EXPECT_FALSE(suballocator.TryFree(a));
+		suballocator.Free(c);
+		EXPECT_EQ(64u, suballocator.TotalFreeArea());
+		EXPECT_EQ(1u, suballocator.FreeBlockCount(3));
+		EXPECT_EQ(TQuadBlock<uint8_t>(0, 0, 3), suballocator.Allocate(8, 8));
+	}
+
+	TEST_F(QuadtreeSuballocatorTest, Grow)
+	{
+		TQuadtreeSuballocator<uint16_t> suballocator(4);
+		auto a = suballocator.Allocate(2, 2);
+		auto b = suballocator.Allocate(1, 1);
+
+		suballocator.Grow();
+		EXPECT_EQ(8u, suballocator.GetSide());
+		EXPECT_EQ(59u, suballocator.TotalFreeArea());
+		EXPECT_TRUE(suballocator.IsBlockAllocated(a));
+		EXPECT_TRUE(suballocator.IsBlockAllocated(b));
+		EXPECT_EQ(TQuadBlock<uint16_t>(4, 0, 2), suballocator.Allocate(3, 3));
+
+		// Everything coalesces across the old boundary
+		suballocator.Free(TQuadBlock<uint16_t>(4, 0, 2));
+		suballocator.Free(a);
+		suballocator.Free(b);
+		EXPECT_EQ(64u, suballocator.TotalFreeArea());
+		EXPECT_EQ(8u, suballocator.MaxAllocationSide());
+
+		// Growing an empty atlas leaves a single free block
+		suballocator.Grow();
+		EXPECT_EQ(1u, suballocator.FreeBlockCount(4));
+		EXPECT_EQ(TQuadBlock<uint16_t>(0, 0, 4), suballocator.Allocate(16, 9));
+
+		// A 256 x 256 tree has more states than a uint16_t can index
+		TQuadtreeSuballocator<uint16_t> largest(128);
+		EXPECT_THROW(largest.Grow(), std::bad_alloc);
+		EXPECT_EQ(128u, largest.GetSide());
+		EXPECT_EQ(128u, largest.MaxAllocationSide());
+		EXPECT_THROW(TQuadtreeSuballocator<uint16_t>(256), std::bad_alloc);
+		EXPECT_THROW(TQuadtreeSuballocator<uint8_t>(16), std::bad_alloc);
+	}
+
+	class ShardedBuddySuballocatorTest : public ::testing::Test
+	{
+	protected:
+		void SetUp() final {}
+		void TearDown() final {}
+	};
+
+	TEST_F(ShardedBuddySuballocatorTest, StealAndRoute)
+	{
+		TShardedBuddySuballocator<unsigned int> suballocator(64, 4);
+		EXPECT_EQ(256u, suballocator.GetCapacity());
+
+		auto home = suballocator.Allocate(64, 1);
+		EXPECT_EQ(64u, home.Start());
+		EXPECT_EQ(0u, suballocator.StealCount());
+
+		// Shard 1 is full, so the request is stolen from the shard with the largest free block
+		auto b = suballocator.Allocate(16, 2);
+		EXPECT_EQ(2u, suballocator.ShardOf(b.Start()));
+		auto stolen = suballocator.Allocate(64, 2);
+		EXPECT_EQ(1u, suballocator.StealCount());
+		EXPECT_NE(1u, suballocator.ShardOf(stolen.Start()));
+		EXPECT_NE(2u, suballocator.ShardOf(stolen.Start()));
+		EXPECT_EQ(256u - 144u, suballocator.TotalFree());
+		EXPECT_EQ(64u, suballocator.MaxAllocationSize());
+
+		// Frees route to the owning shard by offset
+		size_t owner = suballocator.ShardOf(stolen.Start());
+		EXPECT_EQ(0u, suballocator.ShardFree(owner));
+		suballocator.Free(stolen);
+		EXPECT_EQ(64u, suballocator.ShardFree(owner));
+		EXPECT_FALSE(suballocator.IsBlockAllocated(stolen));
+		EXPECT_FALSE(suballocator.TryFree(stolen));
+		EXPECT_THROW(suballocator.Free(TBuddyBlock<unsigned int>(256, 0)), BuddySuballocatorException);
+
+		TBuddyBlock<unsigned int> block;
+		EXPECT_FALSE(suballocator.TryAllocate(128, 0, block));
+
+		suballocator.Free(home);
+		suballocator.Free(b);
+		EXPECT_EQ(256u, suballocator.TotalFree());
+	}
+
+	TEST_F(ShardedBuddySuballocatorTest, InvalidShape)
+	{
+		EXPECT_THROW(TShardedBuddySuballocator<unsigned int>(96, 4), std::invalid_argument);
+		EXPECT_THROW(TShardedBuddySuballocator<unsigned int>(0, 4), std::invalid_argument);
+		EXPECT_THROW(TShardedBuddySuballocator<unsigned int>(64, 0), std::invalid_argument);
+
+		// The capacity must be addressable by the index type
+		EXPECT_THROW(TShardedBuddySuballocator<uint8_t>(64, 5), std::invalid_argument);
+		EXPECT_THROW(TShardedBuddySuballocator<uint8_t>(512, 1), std::invalid_argument);
+		TShardedBuddySuballocator<uint8_t> full(64, 4);
+		EXPECT_EQ(192u, full.Allocate(64, 3).Start());
+	}
+
+	TEST_F(ShardedBuddySuballocatorTest, ConcurrentAllocateFree)
+	{
+		TShardedBuddySuballocator<unsigned int> suballocator(1024, 4);
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < 4; ++t)
+		{
+			threads.emplace_back([&suballocator, t]
+			{
+				std::vector<TBuddyBlock<unsigned int>> blocks;
+				for (int round = 0; round < 50; ++round)
+				{
+					// Each thread needs more than its own shard, forcing steals
+					TBuddyBlock<unsigned int> block;
+					while (suballocator.TryAllocate(1 + (round + blocks.size()) % 40, t, block))
+					{
+						blocks.push_back(block);
+						if (blocks.size() == 40)
+							break;
+					}
+					for (auto& b : blocks)
+						suballocator.Free(b);
+					blocks.clear();
+				}
+			});
+		}
+
+		for (auto& thread : threads)
+			thread.join();
+		EXPECT_EQ(4096u, suballocator.TotalFree());
+		EXPECT_GT(suballocator.StealCount(), 0u);
+	}
+
 	class RingSuballocatorTest : public ::testing::Test
 	{
 	protected:
@@ -765,4 +2687,152 @@ namespace AllocatorsTest
 		EXPECT_TRUE(10 == Loc);
 		Allocator.Reset(64);
 	}
+
+	TEST_F(RingSuballocatorTest, ContiguousModeSkipsTail)
+	{
+		TRingSuballocator<unsigned int> Allocator(100, true);
+		EXPECT_TRUE(Allocator.IsContiguous());
+
+		EXPECT_EQ(0u, Allocator.Allocate(60));
+		EXPECT_EQ(60u, Allocator.Allocate(30));
+		Allocator.Free(60);
+
+		// 20 units don't fit before the end, so the 10 unit tail becomes padding
+		EXPECT_EQ(0u, Allocator.Allocate(20));
+		EXPECT_EQ(40u, Allocator.FreeSize());
+		EXPECT_THROW(Allocator.Allocate(41), std::bad_alloc);
+
+		// Freeing the allocation ahead of the padding reclaims the padding too
+		Allocator.Free(30);
+		EXPECT_EQ(80u, Allocator.FreeSize());
+		Allocator.Free(20);
+		EXPECT_EQ(100u, Allocator.FreeSize());
+
+		// An empty ring can serve the full size
+		EXPECT_EQ(0u, Allocator.Allocate(100));
+		Allocator.Free(100);
+
+		// The default mode still straddles the end
+		TRingSuballocator<unsigned int> Wrapping(100);
+		Wrapping.Allocate(90);
+		Wrapping.Free(90);
+		EXPECT_EQ(90u, Wrapping.Allocate(20));
+		EXPECT_EQ(80u, Wrapping.FreeSize());
+	}
+
+	TEST_F(RingSuballocatorTest, AlignedAllocationPadding)
+	{
+		TRingSuballocator<unsigned int> Allocator(64, true);
+
+		EXPECT_EQ(0u, Allocator.Allocate(3));
+		EXPECT_EQ(16u, Allocator.Allocate(8, 16));
+		EXPECT_EQ(40u, Allocator.FreeSize());
+		EXPECT_EQ(32u, Allocator.Allocate(20, 32));
+
+		// The 12 unit tail is too small for 16 units, so it is skipped
+		unsigned int Loc;
+		EXPECT_FALSE(Allocator.TryAllocate(16, 16, Loc));
+		Allocator.Free(3);
+		EXPECT_EQ(36u, Allocator.AllocatedSize());
+		EXPECT_TRUE(Allocator.TryAllocate(16, 16, Loc));
+		EXPECT_EQ(0u, Loc);
+		EXPECT_EQ(0u, Allocator.FreeSize());
+
+		// Freeing everything at once matches freeing one allocation at a time
+		Allocator.Free(8 + 20 + 16);
+		EXPECT_EQ(0u, Allocator.AllocatedSize());
+		EXPECT_EQ(64u, Allocator.FreeSize());
+	}
+
+	TEST_F(RingSuballocatorTest, RetireCompletedFrames)
+	{
+		TRingSuballocator<unsigned int> Allocator(100, true);
+		uint64_t Fence = 0;
+
+		Allocator.Allocate(10);
+		Allocator.Allocate(30);
+		Allocator.EndFrame(++Fence);
+		Allocator.Allocate(30);
+		Allocator.EndFrame(++Fence);
+
+		// A frame with no allocations is not recorded
+		Allocator.EndFrame(++Fence);
+		EXPECT_EQ(2u, Allocator.PendingFrameCount());
+
+		Allocator.Allocate(5);
+		EXPECT_THROW(Allocator.Allocate(50), std::bad_alloc);
+		EXPECT_EQ(0u, Allocator.Retire(0));
+		EXPECT_EQ(40u, Allocator.Retire(1));
+
+		// 30 units don't fit before the end, so the frame includes 25 units of padding
+		EXPECT_EQ(0u, Allocator.Allocate(30));
+		Allocator.EndFrame(++Fence);
+		EXPECT_EQ(10u, Allocator.FreeSize());
+
+		// Frames are retired in order, padding included
+		EXPECT_EQ(30u, Allocator.Retire(3));
+		EXPECT_EQ(1u, Allocator.PendingFrameCount());
+		EXPECT_EQ(60u, Allocator.Retire(Fence));
+		EXPECT_EQ(0u, Allocator.PendingFrameCount());
+		EXPECT_EQ(100u, Allocator.FreeSize());
+	}
+
+	TEST_F(RingSuballocatorTest, ChainedRingGrowsAndCollapses)
+	{
+		TChainedRingSuballocator<unsigned int> Allocator(64, true);
+		EXPECT_EQ(1u, Allocator.SegmentCount());
+
+		auto A = Allocator.Allocate(40);
+		auto B = Allocator.Allocate(20);
+		EXPECT_EQ((TRingAllocation<unsigned int>{ 0, 0 }), A);
+		EXPECT_EQ((TRingAllocation<unsigned int>{ 0, 40 }), B);
+
+		// Overflow chains a segment of twice the size
+		auto C = Allocator.Allocate(30);
+		EXPECT_EQ((TRingAllocation<unsigned int>{ 1, 0 }), C);
+		EXPECT_EQ(2u, Allocator.SegmentCount());
+		EXPECT_EQ(128u, Allocator.GetSegmentSize(1));
+
+		// Requests larger than twice the size get a large enough segment
+		auto D = Allocator.Allocate(300, 16);
+		EXPECT_EQ((TRingAllocation<unsigned int>{ 2, 0 }), D);
+		EXPECT_EQ(512u, Allocator.GetSegmentSize(2));
+		EXPECT_EQ(390u, Allocator.AllocatedSize());
+
+		// Frees drain the oldest segments first and release them
+		Allocator.Free(50);
+		EXPECT_EQ(3u, Allocator.SegmentCount());
+		Allocator.Free(20);
+		EXPECT_EQ(2u, Allocator.SegmentCount());
+		EXPECT_EQ(1u, Allocator.OldestSegment());
+		EXPECT_EQ(0u, Allocator.GetSegmentSize(0));
+		Allocator.Free(330);
+		EXPECT_EQ(1u, Allocator.SegmentCount());
+		EXPECT_EQ(2u, Allocator.CurrentSegment());
+		EXPECT_EQ(0u, Allocator.AllocatedSize());
+		EXPECT_EQ(512u, Allocator.FreeSize());
+
+		TChainedRingSuballocator<uint8_t> Small(128);
+		TRingAllocation<uint8_t> Out;
+		EXPECT_TRUE(Small.TryAllocate(200, 1, Out));
+		EXPECT_FALSE(Small.TryAllocate(300, 1, Out));
+	}
+
+	TEST_F(RingSuballocatorTest, ChainedRingRetiresFramesAcrossSegments)
+	{
+		TChainedRingSuballocator<unsigned int> Allocator(32);
+
+		Allocator.Allocate(20);
+		Allocator.EndFrame(1);
+		Allocator.Allocate(10);
+		Allocator.Allocate(10);
+		Allocator.EndFrame(2);
+		EXPECT_EQ(2u, Allocator.SegmentCount());
+
+		EXPECT_EQ(20u, Allocator.Retire(1));
+		EXPECT_EQ(2u, Allocator.SegmentCount());
+		EXPECT_EQ(20u, Allocator.Retire(2));
+		EXPECT_EQ(1u, Allocator.SegmentCount());
+		EXPECT_EQ(1u, Allocator.CurrentSegment());
+	}
 }
@@ -0,0 +1,266 @@
+//================================================================================================
+// AsyncSuballocator
+//================================================================================================
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include "ComposableSuballocator.h"
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+#include <coroutine>
+#endif
+
+//------------------------------------------------------------------------------------------------
+// Order in which a TAsyncSuballocator grants waiting requests
+enum class AsyncWaitOrder
+{
+    Fifo,       // Strict arrival order; a request that doesn't fit holds back later ones
+    FirstFit,   // Every waiting request that fits is granted, in arrival order
+};
+
+//------------------------------------------------------------------------------------------------
+// TAsyncSuballocator class
+//
+// Wraps a composable suballocator so that requests wait for space instead of failing.  Threads
+// block in Allocate; in C++20, coroutines suspend on co_await AllocateAsync(Size).  Each Free
+// grants queued requests that now fit, performing the allocation on the waiter's behalf, so a
+// waiter never has to retry.  Granted coroutines are resumed on the thread that called Free,
+// after the lock is released.
+//
+// In Fifo order, new requests queue behind existing waiters even if they would fit, so large
+// requests are not starved by a stream of small ones.  A request that can never fit waits
+// forever; use TryAllocateFor to bound the wait.
+//
+// For example, with a buddy heap:
+//
+//   TAsyncSuballocator<TBuddySuballocatorAdapter<uint32_t>> Heap(TBuddySuballocatorAdapter<uint32_t>(1 << 20));
+//   auto Allocation = co_await Heap.AllocateAsync(4096);
+//   ...
+//   Heap.Free(Allocation);
+//
+// The allocator must outlive every waiter, and a suspended coroutine must not be destroyed
+// while it is waiting.
+template<class _Suballocator>
+class TAsyncSuballocator
+{
+    static_assert(IsComposableSuballocator<_Suballocator>::value, "_Suballocator must be a composable suballocator");
+
+public:
+    using IndexType = typename _Suballocator::IndexType;
+
+private:
+    struct Waiter
+    {
+        size_t Size = 0;
+        TSuballocation<IndexType> Result;
+        bool Granted = false;
+        Waiter* pNextResume = nullptr;
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+        std::coroutine_handle<> Handle; // Null for blocked threads
+#endif
+    };
+
+    _Suballocator m_Suballocator;
+    AsyncWaitOrder m_Order;
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_Granted;
+    std::deque<Waiter*> m_Waiters;
+
+    // Allocates immediately if the wait order allows it.  Must be called with the lock held.
+    bool TryAllocateNow(size_t Size, TSuballocation<IndexType>& Out)
+    {
+        if (m_Order == AsyncWaitOrder::Fifo && !m_Waiters.empty())
+        {
+            return false;
+        }
+
+        return m_Suballocator.TryAllocate(Size, Out);
+    }
+
+    // Grants waiting requests that now fit.  Must be called with the lock held.  Blocked threads
+    // are notified; granted coroutines are returned as a list to resume once the lock is released.
+    Waiter* GrantWaiters()
+    {
+        Waiter* pResume = nullptr;
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+        Waiter** ppResumeTail = &pResume;
+#endif
+        bool NotifyThreads = false;
+
+        for (auto It = m_Waiters.begin(); It != m_Waiters.end();)
+        {
+            Waiter* pWaiter = *It;
+            if (!m_Suballocator.TryAllocate(pWaiter->Size, pWaiter->Result))
+            {
+                if (m_Order == AsyncWaitOrder::Fifo)
+                {
+                    break;
+                }
+
+                ++It;
+                continue;
+            }
+
+            pWaiter->Granted = true;
+            It = m_Waiters.erase(It);
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+            if (pWaiter->Handle)
+            {
+                *ppResumeTail = pWaiter;
+                ppResumeTail = &pWaiter->pNextResume;
+                continue;
+            }
+#endif
+            NotifyThreads = true;
+        }
+
+        if (NotifyThreads)
+        {
+            m_Granted.notify_all();
+        }
+
+        return pResume;
+    }
+
+    static void ResumeWaiters(Waiter* pWaiter)
+    {
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+        while (pWaiter)
+        {
+            // The waiter lives in the coroutine frame, which may be gone after resuming
+            Waiter* pNext = pWaiter->pNextResume;
+            pWaiter->Handle.resume();
+            pWaiter = pNext;
+        }
+#else
+        (void)pWaiter;
+#endif
+    }
+
+public:
+    TAsyncSuballocator(_Suballocator&& Suballocator, AsyncWaitOrder Order = AsyncWaitOrder::Fifo) :
+        m_Suballocator(std::move(Suballocator)),
+        m_Order(Order) {}
+
+    // Non-copyable
+    TAsyncSuballocator(const TAsyncSuballocator&) = delete;
+    TAsyncSuballocator& operator=(const TAsyncSuballocator&) = delete;
+
+    AsyncWaitOrder Order() const { return m_Order; }
+
+    // Number of requests waiting for space
+    size_t WaiterCount() const
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        return m_Waiters.size();
+    }
+
+    // Non-blocking allocation: returns false if the request doesn't fit or, in Fifo order, if
+    // other requests are waiting
+    bool TryAllocate(size_t Size, TSuballocation<IndexType>& Out)
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        return TryAllocateNow(Size, Out);
+    }
+
+    // Blocks the calling thread until the request is granted
+    TSuballocation<IndexType> Allocate(size_t Size)
+    {
+        std::unique_lock<std::mutex> Lock(m_Mutex);
+        Waiter Self;
+        if (TryAllocateNow(Size, Self.Result))
+        {
+            return Self.Result;
+        }
+
+        Self.Size = Size;
+        m_Waiters.push_back(&Self);
+        m_Granted.wait(Lock, [&Self] { return Self.Granted; });
+        return Self.Result;
+    }
+
+    // Blocks the calling thread until the request is granted or Timeout elapses.
+    // Returns false on timeout.
+    template<class _Rep, class _Period>
+    bool TryAllocateFor(size_t Size, const std::chrono::duration<_Rep, _Period>& Timeout, TSuballocation<IndexType>& Out)
+    {
+        std::unique_lock<std::mutex> Lock(m_Mutex);
+        if (TryAllocateNow(Size, Out))
+        {
+            return true;
+        }
+
+        Waiter Self;
+        Self.Size = Size;
+        m_Waiters.push_back(&Self);
+        if (!m_Granted.wait_for(Lock, Timeout, [&Self] { return Self.Granted; }))
+        {
+            m_Waiters.erase(std::find(m_Waiters.begin(), m_Waiters.end(), &Self));
+
+            // Leaving the head of the queue may let the requests behind it through
+            Waiter* pResume = GrantWaiters();
+            Lock.unlock();
+            ResumeWaiters(pResume);
+            return false;
+        }
+
+        Out = Self.Result;
+        return true;
+    }
+
+    // Frees an allocation and grants any waiting requests that now fit
+    void Free(const TSuballocation<IndexType>& Allocation)
+    {
+        std::unique_lock<std::mutex> Lock(m_Mutex);
+        m_Suballocator.Free(Allocation);
+        Waiter* pResume = GrantWaiters();
+        Lock.unlock();
+        ResumeWaiters(pResume);
+    }
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+    // Awaitable returned by AllocateAsync
+    class AllocateAwaiter
+    {
+        TAsyncSuballocator* m_pOwner;
+        Waiter m_Waiter;
+
+    public:
+        AllocateAwaiter(TAsyncSuballocator* pOwner, size_t Size) :
+            m_pOwner(pOwner)
+        {
+            m_Waiter.Size = Size;
+        }
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> Handle)
+        {
+            std::lock_guard<std::mutex> Lock(m_pOwner->m_Mutex);
+            if (m_pOwner->TryAllocateNow(m_Waiter.Size, m_Waiter.Result))
+            {
+                return false;
+            }
+
+            // Once queued, Free may resume the coroutine as soon as the lock is released
+            m_Waiter.Handle = Handle;
+            m_pOwner->m_Waiters.push_back(&m_Waiter);
+            return true;
+        }
+
+        TSuballocation<IndexType> await_resume() const noexcept { return m_Waiter.Result; }
+    };
+
+    // Suspends the awaiting coroutine until the request is granted
+    AllocateAwaiter AllocateAsync(size_t Size)
+    {
+        return AllocateAwaiter(this, Size);
+    }
+#endif
+};
@@ -4,6 +4,11 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <type_traits>
+#include <vector>
+
 //------------------------------------------------------------------------------------------------
 // Bit scanning: platform-optimized and constexpr-portable variants
 //------------------------------------------------------------------------------------------------
@@ -96,6 +101,46 @@ inline unsigned long BitScanMSB64(unsigned long long mask)
 #endif
 }
 
+inline unsigned long BitScanLSB(unsigned long mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return mask ? __builtin_ctzl(mask) : ~0UL;
+#elif defined(_MSC_VER)
+    unsigned long index;
+    return _BitScanForward(&index, mask) ? index : ~0UL;
+#else
+    unsigned long index = 0;
+    if (mask == 0)
+        return ~0UL;
+    while ((mask & 1) == 0)
+    {
+        mask >>= 1;
+        ++index;
+    }
+    return index;
+#endif
+}
+
+inline unsigned long BitScanLSB64(unsigned long long mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return mask ? __builtin_ctzll(mask) : ~0UL;
+#elif defined(_MSC_VER)
+    unsigned long index;
+    return _BitScanForward64(&index, mask) ? index : ~0UL;
+#else
+    unsigned long index = 0;
+    if (mask == 0)
+        return ~0UL;
+    while ((mask & 1) == 0)
+    {
+        mask >>= 1;
+        ++index;
+    }
+    return index;
+#endif
+}
+
 //------------------------------------------------------------------------------------------------
 inline unsigned long Log2Ceil(unsigned int value)
 {
@@ -356,7 +401,7 @@ class TBitArray
 public:
     TBitArray(size_t Size) :
         m_Size(Size),
-        m_NumBytes(Size < 8 ? 1 : m_Size / 8)
+        m_NumBytes(Size < 8 ? 1 : (m_Size + 7) / 8)
     {
         m_pBytes = new Byte[m_NumBytes];
     }
@@ -399,7 +444,7 @@ public:
     // Grow the bit array to NewSize, preserving existing bits (zero-initialized for new bits)
     void Resize(size_t NewSize)
     {
-        size_t newNumBytes = NewSize < 8 ? 1 : NewSize / 8;
+        size_t newNumBytes = NewSize < 8 ? 1 : (NewSize + 7) / 8;
         Byte* pNewBytes = new Byte[newNumBytes];
         // Copy existing data
         size_t copyBytes = (m_NumBytes < newNumBytes) ? m_NumBytes : newNumBytes;
@@ -436,6 +481,13 @@ public:
     {
         return Get(Index);
     }
+
+    // Clears all bits
+    void Clear()
+    {
+        for (size_t i = 0; i < m_NumBytes; ++i)
+            m_pBytes[i].b = 0;
+    }
 };
 
 //------------------------------------------------------------------------------------------------
@@ -465,6 +517,64 @@ public:
     bool operator!=(const TBuddyBlock& o) const { return !operator==(o); }
 };
 
+//------------------------------------------------------------------------------------------------
+// Compact handle packing a TBuddyBlock into a single _IndexType.
+// A block start is always a multiple of the block size, so the order is encoded in the low bits
+// as a run of trailing ones:
+//
+//   Value = (Start << 1) | ((1 << Order) - 1)
+//
+// The shift costs one bit, so handles can represent blocks of allocators with a capacity of up to
+// half the range of _IndexType.  The all-ones value represents the empty block.
+template<typename _IndexType>
+class TBuddyBlockHandle
+{
+    _IndexType m_Value;
+
+public:
+    TBuddyBlockHandle() :
+        m_Value(_IndexType(-1)) {}
+
+    explicit TBuddyBlockHandle(const TBuddyBlock<_IndexType>& Block) :
+        m_Value(Block.Order() == static_cast<uint8_t>(-1) ? _IndexType(-1) :
+            _IndexType((Block.Start() << 1) | ((_IndexType(1) << Block.Order()) - 1))) {}
+
+    static TBuddyBlockHandle FromValue(_IndexType Value)
+    {
+        TBuddyBlockHandle Handle;
+        Handle.m_Value = Value;
+        return Handle;
+    }
+
+    _IndexType Value() const { return m_Value; }
+
+    TBuddyBlock<_IndexType> Block() const
+    {
+        if (m_Value == _IndexType(-1))
+        {
+            return TBuddyBlock<_IndexType>();
+        }
+
+        uint8_t Order = (uint8_t) BitScanLSB64(~(unsigned long long)(m_Value));
+        return TBuddyBlock<_IndexType>(_IndexType((m_Value >> 1) & ~((_IndexType(1) << Order) - 1)), Order);
+    }
+
+    bool operator==(const TBuddyBlockHandle& o) const { return m_Value == o.m_Value; }
+    bool operator!=(const TBuddyBlockHandle& o) const { return !operator==(o); }
+};
+
+//------------------------------------------------------------------------------------------------
+// Selects the narrowest unsigned index type whose TBuddyBlockHandle can represent every block of
+// an allocator with the given compile-time capacity.
+template<size_t _Capacity>
+struct TBuddyIndexTypeForCapacity
+{
+    using Type =
+        typename std::conditional<(_Capacity <= (size_t(1) << 7)), uint8_t,
+        typename std::conditional<(_Capacity <= (size_t(1) << 15)), uint16_t,
+        typename std::conditional<(_Capacity <= (size_t(1) << 31)), uint32_t, uint64_t>::type>::type>::type;
+};
+
 //------------------------------------------------------------------------------------------------
 struct BuddySuballocatorException
 {
@@ -472,6 +582,7 @@ struct BuddySuballocatorException
     {
         Unavailable,
         NotAllocated,
+        InvalidCheckpoint,
     };
 
     Type T;
@@ -479,6 +590,31 @@ struct BuddySuballocatorException
     BuddySuballocatorException(Type t) : T(t) {}
 };
 
+//------------------------------------------------------------------------------------------------
+// Token returned by TBuddySuballocator::Checkpoint, holding the undo log sizes at the checkpoint
+struct BuddyCheckpoint
+{
+    uint64_t Serial = 0;
+    size_t NodeLogSize = 0;
+    size_t ListLogSize = 0;
+    size_t BitLogSize = 0;
+    size_t AllocationCount = 0;
+};
+
+//------------------------------------------------------------------------------------------------
+// Statistics snapshot published by TBuddySuballocator::ReadStatistics
+struct BuddyStatistics
+{
+    size_t FreeUnits = 0;
+    size_t AllocationCount = 0;
+    uint8_t LargestFreeOrder = static_cast<uint8_t>(-1); // -1 if nothing is free
+
+    size_t MaxAllocationSize() const
+    {
+        return LargestFreeOrder == static_cast<uint8_t>(-1) ? 0 : size_t(1) << LargestFreeOrder;
+    }
+};
+
 //------------------------------------------------------------------------------------------------
 // TBuddySuballocator class
 // 
@@ -553,11 +689,124 @@ class TBuddySuballocator
     using _IndexListType = typename TIndexList<_IndexType, _IndexNodeType *>;
     using _BitArrayType = typename TBitArray<_IndexType>;
 
+    // Allocation encodings store 1 + order in the low bits and a generation tag above them.
+    // Reset advances the generation, invalidating every encoding without touching the table.
+    static constexpr unsigned _EncodedOrderBits = sizeof(_IndexType) == 1 ? 4 : sizeof(_IndexType) == 2 ? 5 : sizeof(_IndexType) == 4 ? 6 : 7;
+    static constexpr _IndexType _MaxGeneration = _IndexType(_IndexType(-1) >> _EncodedOrderBits);
+
     size_t m_MaxSize;
     uint8_t m_MaxOrder;
     _IndexNodeType *m_AllocationTable; // Table of all possible allocations
     _IndexListType* m_FreeAllocations;
     _BitArrayType m_SplitStateBitArray;
+    _BitArrayType m_FreeStateBitArray; // Set for blocks currently linked in a free list
+    _IndexType m_Generation = 0;
+
+    // Undo logs recorded while a checkpoint is open
+    struct NodeUndo
+    {
+        _IndexType Index;
+        _IndexNodeType Node;
+    };
+
+    struct ListUndo
+    {
+        uint8_t Order;
+        _IndexListType List;
+    };
+
+    struct BitUndo
+    {
+        _IndexType StateIndex;
+        bool IsFreeState; // Otherwise split state
+        bool Value;
+    };
+
+    bool m_Logging = false;
+    uint64_t m_NextCheckpointSerial = 0;
+    std::vector<uint64_t> m_OpenCheckpoints; // Serials of the checkpoints that can be rolled back, ascending
+    std::vector<NodeUndo> m_NodeLog;
+    std::vector<ListUndo> m_ListLog;
+    std::vector<BitUndo> m_BitLog;
+
+    // Running statistics, kept up to date by the free-list operations
+    size_t m_FreeUnits = 0;
+    unsigned long long m_FreeOrderMask = 0; // Bit n is set if the order-n free list is nonempty
+    size_t m_AllocationCount = 0;
+
+    // Snapshot published under a sequence counter for readers on other threads.  The counter is
+    // odd while an update is in flight.
+    std::atomic<uint32_t> m_StatisticsSequence{ 0 };
+    std::atomic<size_t> m_PublishedFreeUnits{ 0 };
+    std::atomic<size_t> m_PublishedAllocationCount{ 0 };
+    std::atomic<uint8_t> m_PublishedLargestFreeOrder{ static_cast<uint8_t>(-1) };
+
+    uint8_t LargestFreeOrder() const
+    {
+        return m_FreeOrderMask ? uint8_t(BitScanMSB64(m_FreeOrderMask)) : static_cast<uint8_t>(-1);
+    }
+
+    void PublishStatistics()
+    {
+        uint32_t Sequence = m_StatisticsSequence.load(std::memory_order_relaxed);
+        m_StatisticsSequence.store(Sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_PublishedFreeUnits.store(m_FreeUnits, std::memory_order_relaxed);
+        m_PublishedAllocationCount.store(m_AllocationCount, std::memory_order_relaxed);
+        m_PublishedLargestFreeOrder.store(LargestFreeOrder(), std::memory_order_relaxed);
+        m_StatisticsSequence.store(Sequence + 2, std::memory_order_release);
+    }
+
+    // Recomputes the free-space statistics from the free lists
+    void RecountFreeUnits()
+    {
+        m_FreeUnits = 0;
+        m_FreeOrderMask = 0;
+        for (uint8_t Order = 0; Order <= m_MaxOrder; ++Order)
+        {
+            if (m_FreeAllocations[Order].Size())
+            {
+                m_FreeUnits += m_FreeAllocations[Order].Size() << Order;
+                m_FreeOrderMask |= 1ull << Order;
+            }
+        }
+    }
+
+    void LogNode(_IndexType Index)
+    {
+        if (m_Logging)
+        {
+            m_NodeLog.push_back({ Index, m_AllocationTable[Index] });
+        }
+    }
+
+    void LogList(uint8_t Order)
+    {
+        if (m_Logging)
+        {
+            m_ListLog.push_back({ Order, m_FreeAllocations[Order] });
+        }
+    }
+
+    void SetStateBit(_BitArrayType& BitArray, bool IsFreeState, _IndexType StateIndex, bool Value)
+    {
+        if (m_Logging)
+        {
+            bool OldValue = BitArray[StateIndex];
+            if (OldValue == Value)
+            {
+                return;
+            }
+            m_BitLog.push_back({ StateIndex, IsFreeState, OldValue });
+        }
+
+        BitArray.Set(StateIndex, Value);
+    }
+
+    void SetSplitState(_IndexType StateIndex, bool Value)
+    {
+        SetStateBit(m_SplitStateBitArray, false, StateIndex, Value);
+    }
 
     // Returns the buddy block
     static TBuddyBlock<_IndexType> BuddyBlock(const TBuddyBlock<_IndexType> &Block)
@@ -599,16 +848,105 @@ class TBuddySuballocator
     // Committed blocks are either split or allocated
     bool IsAllocated(const TBuddyBlock<_IndexType>& Block) const
     {
-        return _IndexType(Block.Order() + 1) == m_FreeAllocations->GetEncodedValue(m_AllocationTable, Block.Start());
+        return EncodeAllocation(Block.Order()) == m_FreeAllocations->GetEncodedValue(m_AllocationTable, Block.Start());
+    }
+
+    // Returns true if the block is linked in the free list for its order
+    bool IsFree(const TBuddyBlock<_IndexType>& Block) const
+    {
+        return m_FreeStateBitArray[StateIndex(Block)];
+    }
+
+    _IndexType EncodeAllocation(uint8_t Order) const
+    {
+        return _IndexType((m_Generation << _EncodedOrderBits) | _IndexType(Order + 1));
     }
 
     void TrackNodeAsAllocated(const TBuddyBlock<_IndexType>& Block)
     {
-        // Encode the node with 1 + allocation order
-        m_FreeAllocations->SetEncodedValue(m_AllocationTable, Block.Start(), Block.Order() + 1);
+        // Encode the node with the generation and 1 + allocation order
+        LogNode(Block.Start());
+        m_FreeAllocations->SetEncodedValue(m_AllocationTable, Block.Start(), EncodeAllocation(Block.Order()));
+    }
+
+    void UntrackNode(_IndexType Start)
+    {
+        // Degenerate the node by indexing self, clearing any allocation encoding
+        LogNode(Start);
+        m_AllocationTable[Start].Prev = Start;
+        m_AllocationTable[Start].Next = Start;
+    }
+
+    // Untracks every node in [First, Last)
+    void UntrackNodes(size_t First, size_t Last)
+    {
+        for (size_t i = First; i < Last; ++i)
+        {
+            UntrackNode(_IndexType(i));
+        }
+    }
+
+    void PushFreeBlock(const TBuddyBlock<_IndexType>& Block)
+    {
+        auto& FreeList = m_FreeAllocations[Block.Order()];
+        if (m_Logging)
+        {
+            // PushFront relinks the node and the current first node
+            LogList(Block.Order());
+            LogNode(Block.Start());
+            if (FreeList.Size())
+            {
+                LogNode(FreeList.Begin().Index());
+            }
+        }
+
+        FreeList.PushFront(Block.Start(), m_AllocationTable);
+        SetStateBit(m_FreeStateBitArray, true, StateIndex(Block), true);
+        m_FreeUnits += Block.Size();
+        m_FreeOrderMask |= 1ull << Block.Order();
+    }
+
+    void RemoveFreeBlock(const TBuddyBlock<_IndexType>& Block)
+    {
+        auto& FreeList = m_FreeAllocations[Block.Order()];
+        if (m_Logging)
+        {
+            // Remove relinks the node and its neighbors
+            const auto& Node = m_AllocationTable[Block.Start()];
+            _IndexType Prev = Node.Prev;
+            _IndexType Next = Node.Next;
+            LogList(Block.Order());
+            LogNode(Block.Start());
+            if (Prev != Block.Start())
+            {
+                LogNode(Prev);
+            }
+            if (Next != Block.Start())
+            {
+                LogNode(Next);
+            }
+        }
+
+        FreeList.Remove(Block.Start(), m_AllocationTable);
+        SetStateBit(m_FreeStateBitArray, true, StateIndex(Block), false);
+        m_FreeUnits -= Block.Size();
+        if (FreeList.Size() == 0)
+        {
+            m_FreeOrderMask &= ~(1ull << Block.Order());
+        }
     }
 
+    // Allocates a new block, counting it and publishing statistics
     TBuddyBlock<_IndexType> AllocateImpl(uint8_t Order)
+    {
+        auto Block = TakeBlockImpl(Order);
+        ++m_AllocationCount;
+        PublishStatistics();
+        return Block;
+    }
+
+    // Takes a block of the given order, splitting larger blocks as needed
+    TBuddyBlock<_IndexType> TakeBlockImpl(uint8_t Order)
     {
         if (Order <= m_MaxOrder)
         {
@@ -617,12 +955,12 @@ class TBuddySuballocator
                 auto It = m_FreeAllocations[Order].Begin();
                 auto Start = It.Index();
                 auto Block = TBuddyBlock<_IndexType>(Start, Order);
-                m_FreeAllocations[Order].PopFront(m_AllocationTable);
+                RemoveFreeBlock(Block);
                 if (Order < m_MaxOrder)
                 {
                     auto ParentBlock = TBuddySuballocator::ParentBlock(Block);
                     auto StateIndex = TBuddySuballocator::StateIndex(ParentBlock);
-                    m_SplitStateBitArray.Set(StateIndex, false); // Mark the parent as not split
+                    SetSplitState(StateIndex, false); // Mark the parent as not split
                 }
 
                 TrackNodeAsAllocated(Block);
@@ -631,7 +969,7 @@ class TBuddySuballocator
             }
             else
             {
-                auto ParentBlock = AllocateImpl(Order + 1);
+                auto ParentBlock = TakeBlockImpl(Order + 1);
                 auto StateIndex = TBuddySuballocator::StateIndex(ParentBlock);
 
                 if (ParentBlock.Order() != uint8_t(-1))
@@ -639,8 +977,8 @@ class TBuddySuballocator
                     // Split the parent block
                     _IndexType BlockSize = _IndexType(1) << Order;
                     auto Block = TBuddyBlock<_IndexType>(ParentBlock.Start(), Order);
-                    m_FreeAllocations[Order].PushFront(ParentBlock.Start() + BlockSize, m_AllocationTable);
-                    m_SplitStateBitArray.Set(StateIndex, true); // Mark the parent as split
+                    PushFreeBlock(TBuddyBlock<_IndexType>(ParentBlock.Start() + BlockSize, Order));
+                    SetSplitState(StateIndex, true); // Mark the parent as split
 
                     TrackNodeAsAllocated(Block);
 
@@ -652,12 +990,150 @@ class TBuddySuballocator
         throw(BuddySuballocatorException(BuddySuballocatorException::Type::Unavailable));
     }
 
+    // Removes FreeBlock from the free lists and splits it down to Target, returning the unused
+    // halves along the path to the free lists.  Target must lie within FreeBlock.
+    void CarveBlock(const TBuddyBlock<_IndexType>& FreeBlock, const TBuddyBlock<_IndexType>& Target)
+    {
+        RemoveFreeBlock(FreeBlock);
+        if (FreeBlock.Order() < m_MaxOrder)
+        {
+            SetSplitState(StateIndex(ParentBlock(FreeBlock)), false); // Mark the parent as not split
+        }
+
+        for (uint8_t Order = FreeBlock.Order(); Order > Target.Order(); --Order)
+        {
+            uint8_t ChildOrder = Order - 1;
+            TBuddyBlock<_IndexType> Current(Target.Start() & ~((_IndexType(1) << Order) - 1), Order);
+            TBuddyBlock<_IndexType> Child(Target.Start() & ~((_IndexType(1) << ChildOrder) - 1), ChildOrder);
+            PushFreeBlock(BuddyBlock(Child));
+            SetSplitState(StateIndex(Current), true); // Mark the block as split
+        }
+
+        TrackNodeAsAllocated(Target);
+        ++m_AllocationCount;
+        PublishStatistics();
+    }
+
+    // Depth-first search for the lowest-addressed free block able to hold a block of the given
+    // order starting at a multiple of (1 << AlignOrder) within [Lo, Hi).  AlignOrder must be at
+    // least Order.  Allocated subtrees, subtrees outside the window and unaligned subtrees are
+    // skipped without being visited.
+    bool FindConstrainedBlock(const TBuddyBlock<_IndexType>& Node, uint8_t Order, uint8_t AlignOrder, size_t Lo, size_t Hi,
+        TBuddyBlock<_IndexType>& FreeBlock, TBuddyBlock<_IndexType>& Target) const
+    {
+        size_t NodeStart = Node.Start();
+        size_t NodeEnd = NodeStart + Node.Size();
+        size_t AlignMask = (size_t(1) << AlignOrder) - 1;
+
+        if (NodeEnd <= Lo || NodeStart >= Hi)
+        {
+            return false;
+        }
+
+        if (Node.Order() < AlignOrder && (NodeStart & AlignMask) != 0)
+        {
+            return false;
+        }
+
+        if (IsFree(Node))
+        {
+            // Find the lowest qualifying start within the free block
+            size_t Start = ((NodeStart > Lo ? NodeStart : Lo) + AlignMask) & ~AlignMask;
+            size_t End = NodeEnd < Hi ? NodeEnd : Hi;
+            if (Start + (size_t(1) << Order) <= End)
+            {
+                FreeBlock = Node;
+                Target = TBuddyBlock<_IndexType>(_IndexType(Start), Order);
+                return true;
+            }
+
+            return false;
+        }
+
+        if (Node.Order() <= Order || IsAllocated(Node))
+        {
+            return false;
+        }
+
+        uint8_t ChildOrder = Node.Order() - 1;
+        TBuddyBlock<_IndexType> Left(Node.Start(), ChildOrder);
+        TBuddyBlock<_IndexType> Right(Node.Start() + (_IndexType(1) << ChildOrder), ChildOrder);
+        return FindConstrainedBlock(Left, Order, AlignOrder, Lo, Hi, FreeBlock, Target) ||
+            FindConstrainedBlock(Right, Order, AlignOrder, Lo, Hi, FreeBlock, Target);
+    }
+
+    // Visits the allocated or free blocks within Node in address order.  Free blocks end the
+    // descent, so fully free subtrees cost a single bit test.  A node that is neither free nor
+    // allocated is in use by blocks below it.
+    template<class _Visitor>
+    void VisitBlocks(const TBuddyBlock<_IndexType>& Node, bool VisitAllocated, _Visitor& Visitor) const
+    {
+        if (IsFree(Node))
+        {
+            if (!VisitAllocated)
+            {
+                Visitor(Node);
+            }
+            return;
+        }
+
+        if (IsAllocated(Node))
+        {
+            if (VisitAllocated)
+            {
+                Visitor(Node);
+            }
+            return;
+        }
+
+        if (Node.Order() == 0)
+        {
+            return;
+        }
+
+        uint8_t ChildOrder = Node.Order() - 1;
+        VisitBlocks(TBuddyBlock<_IndexType>(Node.Start(), ChildOrder), VisitAllocated, Visitor);
+        VisitBlocks(TBuddyBlock<_IndexType>(Node.Start() + (_IndexType(1) << ChildOrder), ChildOrder), VisitAllocated, Visitor);
+    }
+
+    TBuddyBlock<_IndexType> AllocateConstrainedImpl(uint8_t Order, uint8_t AlignOrder, size_t Lo, size_t Hi)
+    {
+        if (AlignOrder < Order)
+        {
+            AlignOrder = Order;
+        }
+
+        if (Hi > m_MaxSize)
+        {
+            Hi = m_MaxSize;
+        }
+
+        if (Order <= m_MaxOrder)
+        {
+            if (AlignOrder == Order && Lo == 0 && Hi == m_MaxSize)
+            {
+                // Buddy blocks are naturally aligned to their own size
+                return AllocateImpl(Order);
+            }
+
+            TBuddyBlock<_IndexType> FreeBlock;
+            TBuddyBlock<_IndexType> Target;
+            if (FindConstrainedBlock(TBuddyBlock<_IndexType>(0, m_MaxOrder), Order, AlignOrder, Lo, Hi, FreeBlock, Target))
+            {
+                CarveBlock(FreeBlock, Target);
+                return Target;
+            }
+        }
+
+        throw(BuddySuballocatorException(BuddySuballocatorException::Type::Unavailable));
+    }
+
     void FreeImpl(const TBuddyBlock<_IndexType> &Block)
     {
         if (Block.Order() == m_MaxOrder)
         {
             // Add the block to the free list
-            m_FreeAllocations[Block.Order()].PushFront(Block.Start(), m_AllocationTable);
+            PushFreeBlock(Block);
         }
         else
         {
@@ -666,11 +1142,14 @@ class TBuddySuballocator
             if (IsSplit(Parent))
             {
                 // Mark parent as not split
-                m_SplitStateBitArray.Set(StateIndex(Parent), false);
+                SetSplitState(StateIndex(Parent), false);
 
                 // Remove the buddy location from the free list
                 auto Buddy = BuddyBlock(Block);
-                m_FreeAllocations[Block.Order()].Remove(Buddy.Start(), m_AllocationTable);
+                RemoveFreeBlock(Buddy);
+
+                // The block no longer exists on its own, so drop its allocation encoding
+                UntrackNode(Block.Start());
 
                 // Free the parent
                 FreeImpl(Parent);
@@ -678,10 +1157,10 @@ class TBuddySuballocator
             else
             {
                 // Add the block to the free list
-                m_FreeAllocations[Block.Order()].PushFront(Block.Start(), m_AllocationTable);
+                PushFreeBlock(Block);
 
                 // Mark the parent as split
-                m_SplitStateBitArray.Set(StateIndex(Parent), true);
+                SetSplitState(StateIndex(Parent), true);
             }
         }
     }
@@ -690,12 +1169,17 @@ public:
     TBuddySuballocator(size_t MaxSize) :
         m_MaxSize(MaxSize),
         m_SplitStateBitArray(MaxSize),
+        m_FreeStateBitArray(2 * MaxSize),
         m_MaxOrder((uint8_t)Log2Ceil(MaxSize))
     {
         m_AllocationTable = new _IndexNodeType[m_MaxSize];
         m_FreeAllocations = new _IndexListType[m_MaxOrder + 1];
 
-        m_FreeAllocations[m_MaxOrder].PushFront(0, m_AllocationTable);
+        // Zeroed nodes other than node 0 would decode as allocation encodings
+        UntrackNodes(0, m_MaxSize);
+
+        PushFreeBlock(TBuddyBlock<_IndexType>(0, m_MaxOrder));
+        PublishStatistics();
     }
 
     ~TBuddySuballocator()
@@ -706,10 +1190,19 @@ public:
 
     size_t GetCapacity() const { return m_MaxSize; }
 
-    // Returns true if the block is entirely free (neither split nor allocated)
+    // Returns true if the block is entirely free, either as a free block itself or as part of
+    // a larger free block
     bool IsBlockFree(const TBuddyBlock<_IndexType>& Block) const
     {
-        return !IsSplit(Block) && !IsAllocated(Block);
+        for (auto Current = Block; Current.Order() != uint8_t(-1); Current = ParentBlock(Current))
+        {
+            if (IsFree(Current))
+            {
+                return true;
+            }
+        }
+
+        return false;
     }
 
     TBuddyBlock<_IndexType> Allocate(size_t Size)
@@ -733,6 +1226,200 @@ public:
         }
     }
 
+    // Allocates a block of at least Size units whose start is a multiple of Alignment.
+    // Alignment is rounded up to a power of two.  The free tree is searched directly, so no
+    // over-allocation is needed for alignments larger than the block size.
+    TBuddyBlock<_IndexType> AllocateAligned(size_t Size, size_t Alignment)
+    {
+        return AllocateConstrainedImpl((uint8_t) Log2Ceil(Size), (uint8_t) Log2Ceil(Alignment), 0, m_MaxSize);
+    }
+
+    // Allocates a block of at least Size units lying entirely within [Lo, Hi)
+    TBuddyBlock<_IndexType> AllocateInRange(size_t Size, size_t Lo, size_t Hi)
+    {
+        uint8_t Order = (uint8_t) Log2Ceil(Size);
+        return AllocateConstrainedImpl(Order, Order, Lo, Hi);
+    }
+
+    // Allocates the specific block covering [Offset, Offset + Size).  The tree is descended from
+    // the root, splitting only along the path to the target block, in O(MaxOrder) time.
+    // Offset must be a multiple of the block size.  Throws Unavailable if the offset is not
+    // aligned or any part of the block is in use.
+    TBuddyBlock<_IndexType> AllocateAt(_IndexType Offset, size_t Size)
+    {
+        uint8_t Order = (uint8_t) Log2Ceil(Size);
+        size_t BlockSize = size_t(1) << Order;
+
+        if (Order <= m_MaxOrder && (size_t(Offset) & (BlockSize - 1)) == 0 && size_t(Offset) + BlockSize <= m_MaxSize)
+        {
+            TBuddyBlock<_IndexType> Target(Offset, Order);
+            for (uint8_t NodeOrder = m_MaxOrder; ; --NodeOrder)
+            {
+                TBuddyBlock<_IndexType> Node(_IndexType(size_t(Offset) & ~((size_t(1) << NodeOrder) - 1)), NodeOrder);
+                if (IsFree(Node))
+                {
+                    CarveBlock(Node, Target);
+                    return Target;
+                }
+
+                // Stop at an allocated ancestor, or at a target block that is split
+                if (NodeOrder == Order || IsAllocated(Node))
+                {
+                    break;
+                }
+            }
+        }
+
+        throw(BuddySuballocatorException(BuddySuballocatorException::Type::Unavailable));
+    }
+
+    // Non-throwing AllocateAt: returns true on success, false if the block is not available
+    bool TryAllocateAt(_IndexType Offset, size_t Size, TBuddyBlock<_IndexType>& OutBlock)
+    {
+        try
+        {
+            OutBlock = AllocateAt(Offset, Size);
+            return true;
+        }
+        catch (BuddySuballocatorException&)
+        {
+            return false;
+        }
+    }
+
+    // Allocates a block of at least Size units as close as possible to HintOffset, so related
+    // allocations share a subtree and coalesce together when freed.  Walking up from the block
+    // of the requested order containing the hint, each ancestor is taken directly if it is free;
+    // otherwise the subtree on the other side of the walk is searched for the lowest-addressed
+    // fitting block.  The first subtree holding a fit is therefore the smallest enclosing
+    // subtree of the hint that can satisfy the request.  A hint outside the allocation space
+    // falls back to normal placement.
+    TBuddyBlock<_IndexType> AllocateNear(size_t Size, size_t HintOffset)
+    {
+        uint8_t Order = (uint8_t) Log2Ceil(Size);
+        if (Order > m_MaxOrder || HintOffset >= m_MaxSize)
+        {
+            return AllocateImpl(Order);
+        }
+
+        TBuddyBlock<_IndexType> Target(_IndexType(HintOffset & ~((size_t(1) << Order) - 1)), Order);
+        TBuddyBlock<_IndexType> FreeBlock;
+        TBuddyBlock<_IndexType> Found;
+
+        // If the hint lies in an allocated block, nothing inside it can be searched, so the
+        // walk starts from that block instead of from the hint
+        auto Start = Target;
+        for (auto Node = Target; Node.Order() <= m_MaxOrder; Node = ParentBlock(Node))
+        {
+            if (IsAllocated(Node))
+            {
+                Start = Node;
+                break;
+            }
+        }
+
+        if (Start == Target && FindConstrainedBlock(Target, Order, Order, 0, m_MaxSize, FreeBlock, Found))
+        {
+            CarveBlock(FreeBlock, Found);
+            return Found;
+        }
+
+        for (auto Node = Start; Node.Order() < m_MaxOrder; Node = ParentBlock(Node))
+        {
+            auto Parent = ParentBlock(Node);
+            if (IsFree(Parent))
+            {
+                // The hint block itself lies within this free block
+                CarveBlock(Parent, Target);
+                return Target;
+            }
+
+            if (FindConstrainedBlock(BuddyBlock(Node), Order, Order, 0, m_MaxSize, FreeBlock, Found))
+            {
+                CarveBlock(FreeBlock, Found);
+                return Found;
+            }
+        }
+
+        throw(BuddySuballocatorException(BuddySuballocatorException::Type::Unavailable));
+    }
+
+    // Non-throwing AllocateNear: returns true on success, false if no space available
+    bool TryAllocateNear(size_t Size, size_t HintOffset, TBuddyBlock<_IndexType>& OutBlock)
+    {
+        try
+        {
+            OutBlock = AllocateNear(Size, HintOffset);
+            return true;
+        }
+        catch (BuddySuballocatorException&)
+        {
+            return false;
+        }
+    }
+
+    // Allocates up to MaxFragments blocks totaling at least Size units, for callers that can use
+    // non-contiguous ranges when no single free block is large enough.  Each fragment is the
+    // largest free block, until the remainder fits in one free block, which is then allocated
+    // at the smallest order holding it.  Feasibility is checked against the free-list counts
+    // before any state is touched, so a failing request throws Unavailable without side effects.
+    // Writes the fragments to pOutBlocks and returns their count.  Free them together with
+    // FreeBatch.
+    size_t AllocateScatter(size_t Size, size_t MaxFragments, TBuddyBlock<_IndexType>* pOutBlocks)
+    {
+        if (Size == 0)
+        {
+            Size = 1;
+        }
+
+        // Taking the largest block never affects the others, so the greedy placement succeeds
+        // exactly when the MaxFragments largest free blocks cover the request
+        size_t Covered = 0;
+        size_t Fragments = 0;
+        for (int Order = m_MaxOrder; Order >= 0 && Covered < Size && Fragments < MaxFragments; --Order)
+        {
+            size_t Count = (std::min)(m_FreeAllocations[Order].Size(), MaxFragments - Fragments);
+            Covered += Count << Order;
+            Fragments += Count;
+        }
+
+        if (Covered < Size)
+        {
+            throw(BuddySuballocatorException(BuddySuballocatorException::Type::Unavailable));
+        }
+
+        size_t Remaining = Size;
+        size_t Count = 0;
+        for (;;)
+        {
+            size_t LargestFree = MaxAllocationSize();
+            if (LargestFree >= Remaining)
+            {
+                pOutBlocks[Count++] = AllocateImpl((uint8_t) Log2Ceil(Remaining));
+                return Count;
+            }
+
+            pOutBlocks[Count] = AllocateImpl((uint8_t) Log2Ceil(LargestFree));
+            Remaining -= LargestFree;
+            ++Count;
+        }
+    }
+
+    // Non-throwing AllocateScatter: returns true on success, false if the free blocks cannot
+    // cover the request within MaxFragments blocks
+    bool TryAllocateScatter(size_t Size, size_t MaxFragments, TBuddyBlock<_IndexType>* pOutBlocks, size_t& OutCount)
+    {
+        try
+        {
+            OutCount = AllocateScatter(Size, MaxFragments, pOutBlocks);
+            return true;
+        }
+        catch (BuddySuballocatorException&)
+        {
+            return false;
+        }
+    }
+
     // Returns the block size that would be allocated for a given requested size
     // This allows reconstruction of a TBuddyBlock from an offset and the original requested size
     static size_t GetBlockSize(size_t RequestedSize)
@@ -762,6 +1449,8 @@ public:
         }
 
         FreeImpl(Block);
+        --m_AllocationCount;
+        PublishStatistics();
     }
 
     // Non-throwing free: returns true if freed, false if block was not allocated
@@ -770,13 +1459,187 @@ public:
         if (!IsAllocated(Block))
             return false;
         FreeImpl(Block);
+        --m_AllocationCount;
+        PublishStatistics();
         return true;
     }
 
+    void Free(TBuddyBlockHandle<_IndexType> Handle)
+    {
+        Free(Handle.Block());
+    }
+
+    bool TryFree(TBuddyBlockHandle<_IndexType> Handle)
+    {
+        return TryFree(Handle.Block());
+    }
+
+    // Returns true if the block is currently allocated
+    bool IsBlockAllocated(const TBuddyBlock<_IndexType>& Block) const
+    {
+        return IsAllocated(Block);
+    }
+
+    // Calls Visitor(const TBuddyBlock<_IndexType>&) for every allocated block, in address order.
+    // The walk descends only through nodes in use, so its cost is proportional to the number of
+    // allocated and free blocks rather than the capacity.  Visitor must not modify the allocator.
+    template<class _Visitor>
+    void ForEachAllocated(_Visitor Visitor) const
+    {
+        VisitBlocks(TBuddyBlock<_IndexType>(0, m_MaxOrder), true, Visitor);
+    }
+
+    // Calls Visitor(const TBuddyBlock<_IndexType>&) for every free block, in address order
+    template<class _Visitor>
+    void ForEachFree(_Visitor Visitor) const
+    {
+        VisitBlocks(TBuddyBlock<_IndexType>(0, m_MaxOrder), false, Visitor);
+    }
+
+    // Attempts to grow an allocated block in place so that it holds at least NewSize units.
+    // The block is promoted to its parent for as long as it is the left child and its buddy is
+    // free, so the block start never moves.  Returns false without modifying any state if the
+    // block cannot be expanded in place.  On success, Block is updated to the expanded block.
+    bool TryExpand(TBuddyBlock<_IndexType>& Block, size_t NewSize)
+    {
+        if (!IsAllocated(Block))
+        {
+            throw(BuddySuballocatorException(BuddySuballocatorException::Type::NotAllocated));
+        }
+
+        uint8_t NewOrder = (uint8_t) Log2Ceil(NewSize);
+        if (NewOrder <= Block.Order())
+        {
+            return true;
+        }
+
+        if (NewOrder > m_MaxOrder)
+        {
+            return false;
+        }
+
+        // Validate the entire merge path before touching any state
+        for (uint8_t Order = Block.Order(); Order < NewOrder; ++Order)
+        {
+            TBuddyBlock<_IndexType> Current(Block.Start(), Order);
+            bool IsLeftChild = 0 == (Block.Start() & (_IndexType(1) << Order));
+            if (!IsLeftChild || !IsFree(BuddyBlock(Current)))
+            {
+                return false;
+            }
+        }
+
+        for (uint8_t Order = Block.Order(); Order < NewOrder; ++Order)
+        {
+            TBuddyBlock<_IndexType> Current(Block.Start(), Order);
+            RemoveFreeBlock(BuddyBlock(Current));
+
+            // Neither child of the parent is free any longer
+            SetSplitState(StateIndex(ParentBlock(Current)), false);
+        }
+
+        Block = TBuddyBlock<_IndexType>(Block.Start(), NewOrder);
+        TrackNodeAsAllocated(Block);
+        PublishStatistics();
+
+        return true;
+    }
+
+    // Shrinks an allocated block in place to the smallest block holding NewSize units.
+    // The upper halves split off along the way are returned to the free lists.
+    // On return, Block is updated to the shrunk block.
+    void Shrink(TBuddyBlock<_IndexType>& Block, size_t NewSize)
+    {
+        if (!IsAllocated(Block))
+        {
+            throw(BuddySuballocatorException(BuddySuballocatorException::Type::NotAllocated));
+        }
+
+        uint8_t NewOrder = (uint8_t) Log2Ceil(NewSize);
+        if (NewOrder >= Block.Order())
+        {
+            return;
+        }
+
+        for (uint8_t Order = Block.Order(); Order > NewOrder; --Order)
+        {
+            // Keep the lower half and free the upper half
+            uint8_t ChildOrder = Order - 1;
+            PushFreeBlock(TBuddyBlock<_IndexType>(Block.Start() + (_IndexType(1) << ChildOrder), ChildOrder));
+
+            // Mark the split block as split
+            SetSplitState(StateIndex(TBuddyBlock<_IndexType>(Block.Start(), Order)), true);
+        }
+
+        Block = TBuddyBlock<_IndexType>(Block.Start(), NewOrder);
+        TrackNodeAsAllocated(Block);
+        PublishStatistics();
+    }
+
+    // Frees a set of allocated blocks in a single pass.  Blocks are processed from the lowest
+    // order up, and buddies freed in the same batch are merged before touching the free lists,
+    // so each merged pair costs one free-list operation instead of three.  Throws NotAllocated,
+    // without freeing anything, if any block is not allocated or appears more than once.
+    void FreeBatch(const TBuddyBlock<_IndexType>* pBlocks, size_t Count)
+    {
+        std::vector<TBuddyBlock<_IndexType>> Blocks(pBlocks, pBlocks + Count);
+        auto Less = [](const TBuddyBlock<_IndexType>& a, const TBuddyBlock<_IndexType>& b)
+        {
+            return a.Order() != b.Order() ? a.Order() < b.Order() : a.Start() < b.Start();
+        };
+        std::sort(Blocks.begin(), Blocks.end(), Less);
+
+        for (size_t i = 0; i < Blocks.size(); ++i)
+        {
+            if (!IsAllocated(Blocks[i]) || (i > 0 && Blocks[i] == Blocks[i - 1]))
+            {
+                throw(BuddySuballocatorException(BuddySuballocatorException::Type::NotAllocated));
+            }
+        }
+
+        std::vector<TBuddyBlock<_IndexType>> Level;
+        std::vector<TBuddyBlock<_IndexType>> Merged; // Parents of buddies merged at the previous order
+        size_t Index = 0;
+        for (uint8_t Order = 0; Index < Blocks.size() || !Merged.empty(); ++Order)
+        {
+            Level.swap(Merged);
+            Merged.clear();
+            while (Index < Blocks.size() && Blocks[Index].Order() == Order)
+            {
+                Level.push_back(Blocks[Index++]);
+            }
+            std::sort(Level.begin(), Level.end(), Less);
+
+            for (size_t i = 0; i < Level.size(); ++i)
+            {
+                const auto& Block = Level[i];
+                if (Order < m_MaxOrder && i + 1 < Level.size() && Level[i + 1] == BuddyBlock(Block))
+                {
+                    // Both halves are being freed; free the parent instead
+                    UntrackNode(Block.Start());
+                    UntrackNode(Level[i + 1].Start());
+                    Merged.push_back(ParentBlock(Block));
+                    ++i;
+                }
+                else
+                {
+                    FreeImpl(Block);
+                }
+            }
+        }
+
+        m_AllocationCount -= Count;
+        PublishStatistics();
+    }
+
     // Double the capacity of the allocator. Existing allocations keep their offsets.
     // The old tree becomes the left child of a new root; the right half is one free block.
+    // Commits any open checkpoint.
     void Grow()
     {
+        // State indices are remapped below, so the undo logs cannot survive
+        Commit();
+
         size_t oldMaxSize = m_MaxSize;
         uint8_t oldMaxOrder = m_MaxOrder;
         size_t newMaxSize = oldMaxSize * 2;
@@ -788,6 +1651,7 @@ public:
             pNewTable[i] = m_AllocationTable[i];
         delete[] m_AllocationTable;
         m_AllocationTable = pNewTable;
+        UntrackNodes(oldMaxSize, newMaxSize);
 
         // Grow free lists (one list per order, 0..newMaxOrder)
         _IndexListType* pNewFreeLists = new _IndexListType[newMaxOrder + 1];
@@ -804,9 +1668,11 @@ public:
         //   newStateIndex = 2 * oldStateIndex + 1
         // This is because each old level L maps to new level L+1, which starts at 2*(1<<L)-1.
         _BitArrayType newBitArray(newMaxSize);
+        _BitArrayType newFreeBitArray(2 * newMaxSize);
         // Remap split state bits for internal nodes (orders 1..oldMaxOrder).
         // Order-0 blocks cannot be split, so they have no split state to remap.
-        for (uint8_t order = 1; order <= oldMaxOrder; ++order)
+        // Free state bits exist for every order, including order 0.
+        for (uint8_t order = 0; order <= oldMaxOrder; ++order)
         {
             uint8_t oldLevel = oldMaxOrder - order;
             uint8_t newLevel = newMaxOrder - order;
@@ -815,11 +1681,14 @@ public:
             {
                 _IndexType oldStateIdx = (_IndexType(1) << oldLevel) + idx - 1;
                 _IndexType newStateIdx = (_IndexType(1) << newLevel) + idx - 1;
-                if (m_SplitStateBitArray[oldStateIdx])
+                if (order > 0 && m_SplitStateBitArray[oldStateIdx])
                     newBitArray.Set(newStateIdx, true);
+                if (m_FreeStateBitArray[oldStateIdx])
+                    newFreeBitArray.Set(newStateIdx, true);
             }
         }
         m_SplitStateBitArray = std::move(newBitArray);
+        m_FreeStateBitArray = std::move(newFreeBitArray);
 
         // Update capacity
         m_MaxSize = newMaxSize;
@@ -832,53 +1701,293 @@ public:
         if (leftHalfFree)
         {
             // Remove the old root free block and add a full block at the new max order
-            m_FreeAllocations[oldMaxOrder].PopFront(m_AllocationTable);
-            m_FreeAllocations[newMaxOrder].PushFront(0, m_AllocationTable);
+            RemoveFreeBlock(TBuddyBlock<_IndexType>(0, oldMaxOrder));
+            PushFreeBlock(TBuddyBlock<_IndexType>(0, newMaxOrder));
         }
         else
         {
             // Root is split: left half has allocations, right half is free
             auto newRoot = TBuddyBlock<_IndexType>(0, newMaxOrder);
             m_SplitStateBitArray.Set(StateIndex(newRoot), true);
-            m_FreeAllocations[oldMaxOrder].PushFront(
-                static_cast<_IndexType>(oldMaxSize), m_AllocationTable);
+            PushFreeBlock(TBuddyBlock<_IndexType>(static_cast<_IndexType>(oldMaxSize), oldMaxOrder));
         }
+
+        PublishStatistics();
     }
 
+    // Frees every allocation at once, returning the allocator to a single free block.
+    // Allocation encodings are invalidated by advancing the generation tag and the state bit
+    // arrays are cleared in bulk, so the cost does not depend on the number of outstanding
+    // allocations.  The allocation table is cleared in full only when the generation wraps.
+    // Commits any open checkpoint.
+    void Reset()
+    {
+        Commit();
+
+        if (m_Generation == _MaxGeneration)
+        {
+            m_Generation = 0;
+            UntrackNodes(0, m_MaxSize);
+        }
+        else
+        {
+            ++m_Generation;
+        }
+
+        m_SplitStateBitArray.Clear();
+        m_FreeStateBitArray.Clear();
+        for (uint8_t Order = 0; Order <= m_MaxOrder; ++Order)
+        {
+            m_FreeAllocations[Order] = _IndexListType();
+        }
+        m_FreeUnits = 0;
+        m_FreeOrderMask = 0;
+        m_AllocationCount = 0;
+
+        PushFreeBlock(TBuddyBlock<_IndexType>(0, m_MaxOrder));
+        PublishStatistics();
+    }
+
+    // Opens a checkpoint.  Until Commit, every change to the allocation table, free lists and
+    // state bits is recorded in undo logs, so Rollback costs time proportional to the work done
+    // since the checkpoint.  Checkpoints may be nested; rolling back to an outer checkpoint also
+    // undoes the inner ones.
+    BuddyCheckpoint Checkpoint()
+    {
+        m_Logging = true;
+
+        BuddyCheckpoint Token;
+        Token.Serial = m_NextCheckpointSerial++;
+        m_OpenCheckpoints.push_back(Token.Serial);
+        Token.NodeLogSize = m_NodeLog.size();
+        Token.ListLogSize = m_ListLog.size();
+        Token.BitLogSize = m_BitLog.size();
+        Token.AllocationCount = m_AllocationCount;
+        return Token;
+    }
+
+    // Restores the state at the given checkpoint.  The checkpoint stays open, so work can be
+    // retried and rolled back again.  Throws InvalidCheckpoint if the checkpoint was committed
+    // or an outer checkpoint has been rolled back since.
+    void Rollback(const BuddyCheckpoint& Token)
+    {
+        auto It = std::lower_bound(m_OpenCheckpoints.begin(), m_OpenCheckpoints.end(), Token.Serial);
+        if (It == m_OpenCheckpoints.end() || *It != Token.Serial)
+        {
+            throw(BuddySuballocatorException(BuddySuballocatorException::Type::InvalidCheckpoint));
+        }
+
+        // Checkpoints taken after this one are undone with it
+        m_OpenCheckpoints.erase(It + 1, m_OpenCheckpoints.end());
+
+        // Undo in reverse order so the oldest logged value of each entry wins
+        while (m_NodeLog.size() > Token.NodeLogSize)
+        {
+            m_AllocationTable[m_NodeLog.back().Index] = m_NodeLog.back().Node;
+            m_NodeLog.pop_back();
+        }
+
+        while (m_ListLog.size() > Token.ListLogSize)
+        {
+            m_FreeAllocations[m_ListLog.back().Order] = m_ListLog.back().List;
+            m_ListLog.pop_back();
+        }
+
+        while (m_BitLog.size() > Token.BitLogSize)
+        {
+            const auto& Entry = m_BitLog.back();
+            (Entry.IsFreeState ? m_FreeStateBitArray : m_SplitStateBitArray).Set(Entry.StateIndex, Entry.Value);
+            m_BitLog.pop_back();
+        }
+
+        m_AllocationCount = Token.AllocationCount;
+        RecountFreeUnits();
+        PublishStatistics();
+    }
+
+    // Accepts all changes since the outermost checkpoint, invalidating every checkpoint and
+    // ending logging.  Does nothing if no checkpoint is open.
+    void Commit()
+    {
+        if (!m_Logging)
+        {
+            return;
+        }
+
+        m_Logging = false;
+        m_OpenCheckpoints.clear();
+        m_NodeLog.clear();
+        m_ListLog.clear();
+        m_BitLog.clear();
+    }
+
+    // True while a checkpoint is open
+    bool InCheckpoint() const { return m_Logging; }
+
+    // Free units, in constant time
     size_t TotalFree() const
-    { 
-        size_t TotalFree(0);
+    {
+        return m_FreeUnits;
+    }
+
+    size_t MaxAllocationSize() const
+    {
+        return m_FreeOrderMask ? size_t(1) << BitScanMSB64(m_FreeOrderMask) : 0;
+    }
+
+    // Number of live allocations
+    size_t AllocationCount() const
+    {
+        return m_AllocationCount;
+    }
 
-        for (int Order = m_MaxOrder; Order >= 0; Order--)
+    // Returns the statistics as of the most recently completed operation.  Safe to call from any
+    // thread while the owning thread allocates and frees: the owner publishes a snapshot under a
+    // sequence counter after every operation, and the reader retries only if it overlaps an
+    // update.  Readers never block the owner.
+    BuddyStatistics ReadStatistics() const
+    {
+        BuddyStatistics Statistics;
+        for (;;)
         {
-            size_t Size = size_t(1) << Order;
+            uint32_t Sequence = m_StatisticsSequence.load(std::memory_order_acquire);
+            if (Sequence & 1)
+            {
+                continue;
+            }
 
-            if (m_FreeAllocations[Order].Size() > 0)
+            Statistics.FreeUnits = m_PublishedFreeUnits.load(std::memory_order_relaxed);
+            Statistics.AllocationCount = m_PublishedAllocationCount.load(std::memory_order_relaxed);
+            Statistics.LargestFreeOrder = m_PublishedLargestFreeOrder.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_StatisticsSequence.load(std::memory_order_relaxed) == Sequence)
             {
-                for (auto It = m_FreeAllocations[Order].Begin(); ; It.MoveNext(m_AllocationTable))
-                {
-                    TotalFree += Size;
-                    if (It == m_FreeAllocations[Order].End()) break;
-                }
+                return Statistics;
             }
         }
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// TDeferredBuddySuballocator class
+//
+// Extends TBuddySuballocator with a fence-based deferred free queue.  Blocks that may still be
+// in use by in-flight work are queued with FreeAfter, tagged with the fence value that signals
+// completion of that work.  Retire releases every queued block whose fence value has completed
+// using a single coalescing FreeBatch pass.
+//
+// Fence values are opaque 64-bit counters (e.g. a GPU fence or frame number) and need not be
+// queued in increasing order.  Each block can be queued once; a queued block cannot be freed
+// with Free or queued again.  A queued block that goes away some other way (FreeBatch,
+// Rollback or resizing) is dropped from the queue when its fence completes, so it must not be
+// reallocated before then.
+//
+// Checkpoints cover the allocator state only; Rollback does not restore the queue of pending frees.
+template<class _IndexType>
+class TDeferredBuddySuballocator : public TBuddySuballocator<_IndexType>
+{
+    struct PendingFree
+    {
+        TBuddyBlock<_IndexType> Block;
+        uint64_t FenceValue;
+    };
+
+    std::vector<PendingFree> m_PendingFrees;
+    std::vector<TBuddyBlock<_IndexType>> m_RetiredBlocks;
+    TBitArray<_IndexType> m_QueuedStarts; // Set at the start of every queued block
 
-        return TotalFree;
+    bool IsQueued(const TBuddyBlock<_IndexType>& Block) const
+    {
+        return size_t(Block.Start()) < m_QueuedStarts.Size() && m_QueuedStarts[Block.Start()];
     }
 
-    size_t MaxAllocationSize() const
+public:
+    TDeferredBuddySuballocator(size_t MaxSize) :
+        TBuddySuballocator<_IndexType>(MaxSize),
+        m_QueuedStarts(MaxSize) {}
+
+    size_t PendingFreeCount() const { return m_PendingFrees.size(); }
+
+    // Frees every allocation and discards all queued frees
+    void Reset()
+    {
+        m_PendingFrees.clear();
+        m_QueuedStarts.Clear();
+        TBuddySuballocator<_IndexType>::Reset();
+    }
+
+    // Queues an allocated block to be freed once FenceValue has completed.
+    // Throws NotAllocated if the block is not allocated or is already queued.
+    void FreeAfter(const TBuddyBlock<_IndexType>& Block, uint64_t FenceValue)
     {
-        size_t MaxSize = 0;
-        for (int Order = m_MaxOrder; Order >= 0; Order--)
+        if (!this->IsBlockAllocated(Block) || IsQueued(Block))
         {
-            if (m_FreeAllocations[Order].Size() != 0)
+            throw(BuddySuballocatorException(BuddySuballocatorException::Type::NotAllocated));
+        }
+
+        if (m_QueuedStarts.Size() < this->GetCapacity())
+        {
+            m_QueuedStarts.Resize(this->GetCapacity());
+        }
+
+        m_QueuedStarts.Set(Block.Start(), true);
+        m_PendingFrees.push_back(PendingFree{ Block, FenceValue });
+    }
+
+    // Frees a block immediately.  Throws NotAllocated if the block is queued.
+    void Free(const TBuddyBlock<_IndexType>& Block)
+    {
+        if (IsQueued(Block))
+        {
+            throw(BuddySuballocatorException(BuddySuballocatorException::Type::NotAllocated));
+        }
+
+        TBuddySuballocator<_IndexType>::Free(Block);
+    }
+
+    // Non-throwing free: returns false if the block is not allocated or is queued
+    bool TryFree(const TBuddyBlock<_IndexType>& Block)
+    {
+        return !IsQueued(Block) && TBuddySuballocator<_IndexType>::TryFree(Block);
+    }
+
+    void Free(TBuddyBlockHandle<_IndexType> Handle)
+    {
+        Free(Handle.Block());
+    }
+
+    bool TryFree(TBuddyBlockHandle<_IndexType> Handle)
+    {
+        return TryFree(Handle.Block());
+    }
+
+    // Frees all queued blocks with a fence value less than or equal to CompletedFenceValue.
+    // Entries whose block was freed some other way are dropped.  Returns the number of blocks
+    // freed.
+    size_t Retire(uint64_t CompletedFenceValue)
+    {
+        m_RetiredBlocks.clear();
+        size_t Remaining = 0;
+        for (size_t i = 0; i < m_PendingFrees.size(); ++i)
+        {
+            const auto& Pending = m_PendingFrees[i];
+            if (Pending.FenceValue > CompletedFenceValue)
             {
-                MaxSize = size_t(1) << Order;
-                break;
+                m_PendingFrees[Remaining++] = Pending;
+                continue;
+            }
+
+            m_QueuedStarts.Set(Pending.Block.Start(), false);
+            if (this->IsBlockAllocated(Pending.Block))
+            {
+                m_RetiredBlocks.push_back(Pending.Block);
             }
         }
+        m_PendingFrees.resize(Remaining);
 
-        return MaxSize;
-    }
+        // Queued blocks are distinct and still allocated, so the batch cannot fail
+        this->FreeBatch(m_RetiredBlocks.data(), m_RetiredBlocks.size());
 
-};
\ No newline at end of file
+        return m_RetiredBlocks.size();
+    }
+};
@@ -0,0 +1,400 @@
+//================================================================================================
+// ComposableSuballocator
+//================================================================================================
+
+#pragma once
+
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "BuddySuballocator.h"
+#include "PoolSuballocator.h"
+#include "RingSuballocator.h"
+#include "TlsfSuballocator.h"
+
+//------------------------------------------------------------------------------------------------
+// Composable suballocators
+//
+// The standalone suballocators differ in how they report results and failures.
+// TBuddySuballocator returns a TBuddyBlock and throws BuddySuballocatorException,
+// TPoolSuballocator returns an offset and throws std::bad_alloc, and so on.  The types in this
+// file put them behind one compile-time interface so they can be combined with policy templates
+// and no virtual dispatch.
+//
+// A composable suballocator is any type providing:
+//
+//   using IndexType = ...;
+//   bool TryAllocate(size_t Size, TSuballocation<IndexType>& Out);
+//   void Free(const TSuballocation<IndexType>& Allocation);
+//   bool Owns(const TSuballocation<IndexType>& Allocation) const;
+//
+// TryAllocate never throws for lack of space.  Free accepts the exact TSuballocation returned by
+// TryAllocate.  Owns reports whether the allocation came from this suballocator.  Each adapter
+// is given a base offset, so suballocators sharing one address space must be given disjoint
+// ranges.
+//
+// Example size-tiered heap: a pool for tiny sizes, buddy for mid sizes and TLSF for the rest:
+//
+//   using Heap = TSegregator<4, TPoolSuballocatorAdapter<uint32_t>,
+//                TSegregator<4096, TBuddySuballocatorAdapter<uint32_t>,
+//                                  TTlsfSuballocatorAdapter<uint32_t>>>;
+//
+//   Heap heap(TPoolSuballocatorAdapter<uint32_t>(1024, 4, 0),
+//             { TBuddySuballocatorAdapter<uint32_t>(1 << 16, 4096),
+//               TTlsfSuballocatorAdapter<uint32_t>(1 << 20, 4096 + (1 << 16)) });
+
+//------------------------------------------------------------------------------------------------
+// Result of a composable allocation.  Size is the requested size, which the owning suballocator
+// uses to reconstruct its internal block when freeing.
+template<typename _IndexType>
+struct TSuballocation
+{
+    _IndexType Offset = 0;
+    size_t Size = 0;
+
+    bool operator==(const TSuballocation& o) const { return Offset == o.Offset && Size == o.Size; }
+    bool operator!=(const TSuballocation& o) const { return !operator==(o); }
+};
+
+//------------------------------------------------------------------------------------------------
+// Detects whether _Suballocator satisfies the composable suballocator interface
+template<class _Suballocator, class = void>
+struct IsComposableSuballocator : std::false_type {};
+
+template<class _Suballocator>
+struct IsComposableSuballocator<_Suballocator, std::void_t<
+    typename _Suballocator::IndexType,
+    decltype(std::declval<_Suballocator&>().TryAllocate(size_t(0), std::declval<TSuballocation<typename _Suballocator::IndexType>&>())),
+    decltype(std::declval<_Suballocator&>().Free(std::declval<const TSuballocation<typename _Suballocator::IndexType>&>())),
+    decltype(std::declval<const _Suballocator&>().Owns(std::declval<const TSuballocation<typename _Suballocator::IndexType>&>()))>>
+    : std::true_type {};
+
+//------------------------------------------------------------------------------------------------
+// Adapts a TBuddySuballocator covering [BaseOffset, BaseOffset + Capacity)
+template<class _IndexType>
+class TBuddySuballocatorAdapter
+{
+    std::unique_ptr<TBuddySuballocator<_IndexType>> m_pAllocator;
+    _IndexType m_BaseOffset;
+
+public:
+    using IndexType = _IndexType;
+
+    TBuddySuballocatorAdapter(size_t Capacity, _IndexType BaseOffset = 0) :
+        m_pAllocator(new TBuddySuballocator<_IndexType>(Capacity)),
+        m_BaseOffset(BaseOffset) {}
+
+    TBuddySuballocator<_IndexType>& Get() { return *m_pAllocator; }
+    const TBuddySuballocator<_IndexType>& Get() const { return *m_pAllocator; }
+
+    bool TryAllocate(size_t Size, TSuballocation<_IndexType>& Out)
+    {
+        TBuddyBlock<_IndexType> Block;
+        if (!m_pAllocator->TryAllocate(Size, Block))
+        {
+            return false;
+        }
+
+        Out.Offset = _IndexType(m_BaseOffset + Block.Start());
+        Out.Size = Size;
+        return true;
+    }
+
+    void Free(const TSuballocation<_IndexType>& Allocation)
+    {
+        m_pAllocator->Free(TBuddySuballocator<_IndexType>::ReconstructBlock(_IndexType(Allocation.Offset - m_BaseOffset), Allocation.Size));
+    }
+
+    bool Owns(const TSuballocation<_IndexType>& Allocation) const
+    {
+        return Allocation.Offset >= m_BaseOffset && size_t(Allocation.Offset - m_BaseOffset) < m_pAllocator->GetCapacity();
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// Adapts a TPoolSuballocator covering [BaseOffset, BaseOffset + NumSlots * SlotSize).
+// Requests larger than SlotSize fail.
+template<class _IndexType>
+class TPoolSuballocatorAdapter
+{
+    std::unique_ptr<TPoolSuballocator<_IndexType>> m_pAllocator;
+    _IndexType m_BaseOffset;
+
+public:
+    using IndexType = _IndexType;
+
+    TPoolSuballocatorAdapter(size_t NumSlots, size_t SlotSize, _IndexType BaseOffset = 0) :
+        m_pAllocator(new TPoolSuballocator<_IndexType>(NumSlots, SlotSize)),
+        m_BaseOffset(BaseOffset) {}
+
+    TPoolSuballocator<_IndexType>& Get() { return *m_pAllocator; }
+    const TPoolSuballocator<_IndexType>& Get() const { return *m_pAllocator; }
+
+    bool TryAllocate(size_t Size, TSuballocation<_IndexType>& Out)
+    {
+        _IndexType Offset;
+        if (Size > m_pAllocator->SlotSize() || !m_pAllocator->TryAllocate(Offset))
+        {
+            return false;
+        }
+
+        Out.Offset = _IndexType(m_BaseOffset + Offset);
+        Out.Size = Size;
+        return true;
+    }
+
+    void Free(const TSuballocation<_IndexType>& Allocation)
+    {
+        m_pAllocator->Free(_IndexType(Allocation.Offset - m_BaseOffset));
+    }
+
+    bool Owns(const TSuballocation<_IndexType>& Allocation) const
+    {
+        return Allocation.Offset >= m_BaseOffset &&
+            size_t(Allocation.Offset - m_BaseOffset) < m_pAllocator->SlotCount() * m_pAllocator->SlotSize();
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// Adapts a TTlsfSuballocator covering [BaseOffset, BaseOffset + Capacity)
+template<class _IndexType>
+class TTlsfSuballocatorAdapter
+{
+    std::unique_ptr<TTlsfSuballocator<_IndexType>> m_pAllocator;
+    _IndexType m_BaseOffset;
+
+public:
+    using IndexType = _IndexType;
+
+    TTlsfSuballocatorAdapter(size_t Capacity, _IndexType BaseOffset = 0) :
+        m_pAllocator(new TTlsfSuballocator<_IndexType>(Capacity)),
+        m_BaseOffset(BaseOffset) {}
+
+    TTlsfSuballocator<_IndexType>& Get() { return *m_pAllocator; }
+    const TTlsfSuballocator<_IndexType>& Get() const { return *m_pAllocator; }
+
+    bool TryAllocate(size_t Size, TSuballocation<_IndexType>& Out)
+    {
+        TTlsfBlock<_IndexType> Block;
+        if (!m_pAllocator->TryAllocate(Size, Block))
+        {
+            return false;
+        }
+
+        Out.Offset = _IndexType(m_BaseOffset + Block.Start());
+        Out.Size = Size;
+        return true;
+    }
+
+    void Free(const TSuballocation<_IndexType>& Allocation)
+    {
+        // Zero-sized requests occupy one unit
+        size_t Size = Allocation.Size ? Allocation.Size : 1;
+        m_pAllocator->Free(TTlsfBlock<_IndexType>(_IndexType(Allocation.Offset - m_BaseOffset), _IndexType(Size)));
+    }
+
+    bool Owns(const TSuballocation<_IndexType>& Allocation) const
+    {
+        return Allocation.Offset >= m_BaseOffset && size_t(Allocation.Offset - m_BaseOffset) < m_pAllocator->GetCapacity();
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// Adapts a contiguous-mode TRingSuballocator covering [BaseOffset, BaseOffset + Capacity).
+// The ring frees in FIFO order, so allocations must be freed oldest first; Free throws
+// std::invalid_argument for any other allocation.
+template<class _IndexType>
+class TRingSuballocatorAdapter
+{
+    std::unique_ptr<TRingSuballocator<_IndexType>> m_pAllocator;
+    _IndexType m_BaseOffset;
+    size_t m_Capacity;
+
+public:
+    using IndexType = _IndexType;
+
+    TRingSuballocatorAdapter(size_t Capacity, _IndexType BaseOffset = 0) :
+        m_pAllocator(new TRingSuballocator<_IndexType>(Capacity, true)),
+        m_BaseOffset(BaseOffset),
+        m_Capacity(Capacity) {}
+
+    TRingSuballocator<_IndexType>& Get() { return *m_pAllocator; }
+    const TRingSuballocator<_IndexType>& Get() const { return *m_pAllocator; }
+
+    bool TryAllocate(size_t Size, TSuballocation<_IndexType>& Out)
+    {
+        _IndexType Offset;
+        if (!m_pAllocator->TryAllocate(Size, 1, Offset))
+        {
+            return false;
+        }
+
+        Out.Offset = _IndexType(m_BaseOffset + Offset);
+        Out.Size = Size;
+        return true;
+    }
+
+    void Free(const TSuballocation<_IndexType>& Allocation)
+    {
+        size_t Live = m_pAllocator->AllocatedSize() - m_pAllocator->PaddingSize();
+        if (Allocation.Size > Live || _IndexType(Allocation.Offset - m_BaseOffset) != m_pAllocator->OldestOffset())
+        {
+            throw std::invalid_argument("Ring allocations must be freed oldest first");
+        }
+
+        m_pAllocator->Free(Allocation.Size);
+    }
+
+    bool Owns(const TSuballocation<_IndexType>& Allocation) const
+    {
+        return Allocation.Offset >= m_BaseOffset && size_t(Allocation.Offset - m_BaseOffset) < m_Capacity;
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// Sends requests of at most _Threshold units to _Small and larger requests to _Large.
+// Frees are routed by the allocation's requested size, so no ownership query is needed.
+template<size_t _Threshold, class _Small, class _Large>
+class TSegregator
+{
+    static_assert(IsComposableSuballocator<_Small>::value, "_Small must be a composable suballocator");
+    static_assert(IsComposableSuballocator<_Large>::value, "_Large must be a composable suballocator");
+    static_assert(std::is_same<typename _Small::IndexType, typename _Large::IndexType>::value, "Index types must match");
+
+    _Small m_Small;
+    _Large m_Large;
+
+public:
+    using IndexType = typename _Small::IndexType;
+
+    TSegregator(_Small&& Small, _Large&& Large) :
+        m_Small(std::move(Small)),
+        m_Large(std::move(Large)) {}
+
+    _Small& Small() { return m_Small; }
+    _Large& Large() { return m_Large; }
+
+    bool TryAllocate(size_t Size, TSuballocation<IndexType>& Out)
+    {
+        return Size <= _Threshold ? m_Small.TryAllocate(Size, Out) : m_Large.TryAllocate(Size, Out);
+    }
+
+    void Free(const TSuballocation<IndexType>& Allocation)
+    {
+        if (Allocation.Size <= _Threshold)
+            m_Small.Free(Allocation);
+        else
+            m_Large.Free(Allocation);
+    }
+
+    bool Owns(const TSuballocation<IndexType>& Allocation) const
+    {
+        return Allocation.Size <= _Threshold ? m_Small.Owns(Allocation) : m_Large.Owns(Allocation);
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// Tries _Primary first and falls back to _Secondary when the primary is out of space.
+// Frees are routed with _Primary::Owns.
+template<class _Primary, class _Secondary>
+class TFallback
+{
+    static_assert(IsComposableSuballocator<_Primary>::value, "_Primary must be a composable suballocator");
+    static_assert(IsComposableSuballocator<_Secondary>::value, "_Secondary must be a composable suballocator");
+    static_assert(std::is_same<typename _Primary::IndexType, typename _Secondary::IndexType>::value, "Index types must match");
+
+    _Primary m_Primary;
+    _Secondary m_Secondary;
+
+public:
+    using IndexType = typename _Primary::IndexType;
+
+    TFallback(_Primary&& Primary, _Secondary&& Secondary) :
+        m_Primary(std::move(Primary)),
+        m_Secondary(std::move(Secondary)) {}
+
+    _Primary& Primary() { return m_Primary; }
+    _Secondary& Secondary() { return m_Secondary; }
+
+    bool TryAllocate(size_t Size, TSuballocation<IndexType>& Out)
+    {
+        return m_Primary.TryAllocate(Size, Out) || m_Secondary.TryAllocate(Size, Out);
+    }
+
+    void Free(const TSuballocation<IndexType>& Allocation)
+    {
+        if (m_Primary.Owns(Allocation))
+            m_Primary.Free(Allocation);
+        else
+            m_Secondary.Free(Allocation);
+    }
+
+    bool Owns(const TSuballocation<IndexType>& Allocation) const
+    {
+        return m_Primary.Owns(Allocation) || m_Secondary.Owns(Allocation);
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// Splits the size range (_Min, _Max] into buckets of _Step units, each served by its own
+// _Suballocator instance.  Bucket i serves sizes in (_Min + i * _Step, _Min + (i + 1) * _Step].
+// Requests outside (_Min, _Max] fail.  The buckets are created by a factory called as
+// Factory(BucketIndex, BucketMaxSize), which must give each bucket a disjoint offset range.
+template<class _Suballocator, size_t _Min, size_t _Max, size_t _Step>
+class TBucketizer
+{
+    static_assert(IsComposableSuballocator<_Suballocator>::value, "_Suballocator must be a composable suballocator");
+    static_assert(_Step > 0 && _Max > _Min && (_Max - _Min) % _Step == 0, "(_Max - _Min) must be a multiple of _Step");
+
+    std::vector<_Suballocator> m_Buckets;
+
+    static size_t BucketIndex(size_t Size)
+    {
+        return (Size - _Min - 1) / _Step;
+    }
+
+    static bool InRange(size_t Size)
+    {
+        return Size > _Min && Size <= _Max;
+    }
+
+public:
+    using IndexType = typename _Suballocator::IndexType;
+
+    static constexpr size_t BucketCount = (_Max - _Min) / _Step;
+
+    template<class _Factory>
+    TBucketizer(_Factory&& Factory)
+    {
+        m_Buckets.reserve(BucketCount);
+        for (size_t i = 0; i < BucketCount; ++i)
+        {
+            m_Buckets.push_back(Factory(i, _Min + (i + 1) * _Step));
+        }
+    }
+
+    _Suballocator& Bucket(size_t Index) { return m_Buckets[Index]; }
+
+    bool TryAllocate(size_t Size, TSuballocation<IndexType>& Out)
+    {
+        return InRange(Size) && m_Buckets[BucketIndex(Size)].TryAllocate(Size, Out);
+    }
+
+    // Throws std::invalid_argument if the allocation's size is outside (_Min, _Max]
+    void Free(const TSuballocation<IndexType>& Allocation)
+    {
+        if (!InRange(Allocation.Size))
+        {
+            throw std::invalid_argument("Allocation size is outside the bucketizer's range");
+        }
+
+        m_Buckets[BucketIndex(Allocation.Size)].Free(Allocation);
+    }
+
+    bool Owns(const TSuballocation<IndexType>& Allocation) const
+    {
+        return InRange(Allocation.Size) && m_Buckets[BucketIndex(Allocation.Size)].Owns(Allocation);
+    }
+};
@@ -0,0 +1,212 @@
+//================================================================================================
+// ConcurrentRingSuballocator
+//================================================================================================
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+//------------------------------------------------------------------------------------------------
+// Space reserved in a TConcurrentRingSuballocator.
+// Offset and Size describe the usable range.  Begin and End are the ring cursors spanning the
+// reservation including any leading padding.
+template<typename _IndexType>
+struct TRingReservation
+{
+    _IndexType Offset = 0;
+    size_t Size = 0;
+    uint64_t Begin = 0;
+    uint64_t End = 0;
+};
+
+//------------------------------------------------------------------------------------------------
+// TConcurrentRingSuballocator class
+//
+// Multi-producer, single-consumer ring.  Any number of threads reserve space concurrently with a
+// compare-and-swap on a shared end cursor, then commit their reservations in any order.  A
+// single consumer thread frees units in reservation order, and Free stops at the first
+// reservation that has not been committed yet.
+//
+// Cursors count units monotonically and are reduced modulo the ring size to get offsets.
+// Committing a reservation publishes its end cursor in a per-unit stamp table at the
+// reservation's first unit.  A stamp greater than the consumer's cursor marks a committed
+// reservation starting there; stamps left from earlier laps are never greater.  Each unit costs
+// an 8-byte stamp plus an _IndexType holding the padding of a reservation starting there, so
+// units should be coarse (e.g. 16 or 64 bytes) for large rings.
+//
+// The ring is not a throughput win over a TRingSuballocator behind a mutex: with few producers
+// or uncontended cores the mutex ring is faster, since every commit here is an extra release
+// store and every Free walks the stamps.  Use it when producers must not block one another or
+// the consumer, e.g. when a producer may be preempted mid-reservation.
+//
+// Contiguous mode and alignment behave as in TRingSuballocator: padding is part of the
+// reservation and is reclaimed by the consumer without being counted by Free.
+//
+// Reserve, TryReserve and Commit may be called from any thread.  Free and CommittedSize must
+// only be called from the consumer thread.
+template<typename _IndexType>
+class TConcurrentRingSuballocator
+{
+    static constexpr size_t _CacheLineSize = 64;
+
+    size_t m_Size;
+    bool m_Contiguous;
+    std::unique_ptr<std::atomic<uint64_t>[]> m_Stamps;
+    std::unique_ptr<_IndexType[]> m_Padding; // Leading padding of the reservation starting at each unit
+
+    alignas(_CacheLineSize) std::atomic<uint64_t> m_Reserved{ 0 };
+    alignas(_CacheLineSize) std::atomic<uint64_t> m_Freed{ 0 };
+
+    // Consumer state: the reservation containing the free cursor
+    alignas(_CacheLineSize) uint64_t m_HeadEnd = 0;
+
+public:
+    TConcurrentRingSuballocator(size_t Size, bool Contiguous = false) :
+        m_Size(Size),
+        m_Contiguous(Contiguous),
+        m_Stamps(new std::atomic<uint64_t>[Size]),
+        m_Padding(new _IndexType[Size])
+    {
+        for (size_t i = 0; i < Size; ++i)
+        {
+            m_Stamps[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // Non-copyable
+    TConcurrentRingSuballocator(const TConcurrentRingSuballocator&) = delete;
+    TConcurrentRingSuballocator& operator=(const TConcurrentRingSuballocator&) = delete;
+
+    size_t Capacity() const { return m_Size; }
+    bool IsContiguous() const { return m_Contiguous; }
+
+    // Snapshot of the units reserved and not yet freed, including padding
+    size_t AllocatedSize() const
+    {
+        return size_t(m_Reserved.load(std::memory_order_acquire) - m_Freed.load(std::memory_order_acquire));
+    }
+
+    size_t FreeSize() const
+    {
+        return m_Size - AllocatedSize();
+    }
+
+    // Reserves Size units at an offset that is a multiple of Alignment.
+    // Zero-sized requests reserve one unit.  Returns false if the request, including any padding,
+    // does not fit.
+    bool TryReserve(size_t Size, size_t Alignment, TRingReservation<_IndexType>& OutReservation)
+    {
+        Size = Size ? Size : 1;
+        Alignment = Alignment ? Alignment : 1;
+
+        uint64_t Begin = m_Reserved.load(std::memory_order_relaxed);
+        size_t Loc;
+        uint64_t End;
+        do
+        {
+            size_t Offset = size_t(Begin % m_Size);
+            Loc = ((Offset + Alignment - 1) / Alignment) * Alignment;
+            if (Loc >= m_Size || (m_Contiguous && Size > m_Size - Loc))
+            {
+                // Skip the tail and continue at offset 0
+                Loc = m_Size;
+            }
+
+            End = Begin + (Loc - Offset) + Size;
+            if (End - m_Freed.load(std::memory_order_acquire) > m_Size)
+            {
+                return false;
+            }
+        } while (!m_Reserved.compare_exchange_weak(Begin, End, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+        OutReservation.Offset = _IndexType(Loc % m_Size);
+        OutReservation.Size = Size;
+        OutReservation.Begin = Begin;
+        OutReservation.End = End;
+        return true;
+    }
+
+    // Throws std::bad_alloc if the request does not fit
+    TRingReservation<_IndexType> Reserve(size_t Size, size_t Alignment = 1)
+    {
+        TRingReservation<_IndexType> Reservation;
+        if (!TryReserve(Size, Alignment, Reservation))
+        {
+            throw std::bad_alloc();
+        }
+
+        return Reservation;
+    }
+
+    // Makes a reservation available to the consumer
+    void Commit(const TRingReservation<_IndexType>& Reservation)
+    {
+        size_t Index = size_t(Reservation.Begin % m_Size);
+        m_Padding[Index] = _IndexType(size_t(Reservation.End - Reservation.Begin) - Reservation.Size);
+        m_Stamps[Index].store(Reservation.End, std::memory_order_release);
+    }
+
+    // Returns the number of committed units ahead of the consumer, excluding padding.
+    // Consumer thread only.
+    size_t CommittedSize() const
+    {
+        uint64_t Cursor = m_Freed.load(std::memory_order_relaxed);
+        uint64_t HeadEnd = m_HeadEnd;
+        size_t Committed = size_t(HeadEnd > Cursor ? HeadEnd - Cursor : 0);
+        Cursor = (std::max)(Cursor, HeadEnd);
+
+        for (;;)
+        {
+            size_t Index = size_t(Cursor % m_Size);
+            uint64_t End = m_Stamps[Index].load(std::memory_order_acquire);
+            if (End <= Cursor)
+            {
+                return Committed;
+            }
+
+            Committed += size_t(End - Cursor) - size_t(m_Padding[Index]);
+            Cursor = End;
+        }
+    }
+
+    // Frees up to Size committed units in reservation order, reclaiming padding along the way.
+    // Stops early at the first uncommitted reservation.  Returns the number of units freed,
+    // excluding padding.  Consumer thread only.
+    size_t Free(size_t Size)
+    {
+        uint64_t Cursor = m_Freed.load(std::memory_order_relaxed);
+        size_t Freed = 0;
+        for (;;)
+        {
+            if (Cursor == m_HeadEnd)
+            {
+                // Move to the next reservation if it has been committed
+                size_t Index = size_t(Cursor % m_Size);
+                uint64_t End = m_Stamps[Index].load(std::memory_order_acquire);
+                if (End <= Cursor)
+                {
+                    break;
+                }
+
+                m_HeadEnd = End;
+                Cursor += size_t(m_Padding[Index]);
+            }
+
+            if (Freed == Size)
+            {
+                break;
+            }
+
+            size_t Run = (std::min)(Size - Freed, size_t(m_HeadEnd - Cursor));
+            Cursor += Run;
+            Freed += Run;
+        }
+
+        m_Freed.store(Cursor, std::memory_order_release);
+        return Freed;
+    }
+};
@@ -0,0 +1,390 @@
+//================================================================================================
+// FileStagingPipeline
+//================================================================================================
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include "SpscByteChannel.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//------------------------------------------------------------------------------------------------
+// Read-only file with positional reads and whole-file mapping
+class StagingFile
+{
+#ifdef _WIN32
+    HANDLE m_hFile = INVALID_HANDLE_VALUE;
+    HANDLE m_hMapping = nullptr;
+#else
+    int m_File = -1;
+#endif
+    uint64_t m_Size = 0;
+    const uint8_t* m_pMapped = nullptr;
+    uint64_t m_MappedSize = 0;
+
+public:
+    StagingFile() = default;
+    ~StagingFile() { Close(); }
+
+    // Non-copyable
+    StagingFile(const StagingFile&) = delete;
+    StagingFile& operator=(const StagingFile&) = delete;
+
+    uint64_t Size() const { return m_Size; }
+
+    // Length of the mapping, which is the file size when Map was first called
+    uint64_t MappedSize() const { return m_MappedSize; }
+
+    bool Open(const char* pPath)
+    {
+        Close();
+#ifdef _WIN32
+        m_hFile = CreateFileA(pPath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        LARGE_INTEGER FileSize;
+        if (m_hFile == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_hFile, &FileSize))
+        {
+            Close();
+            return false;
+        }
+        m_Size = uint64_t(FileSize.QuadPart);
+#else
+        m_File = open(pPath, O_RDONLY);
+        struct stat FileStat;
+        if (m_File < 0 || fstat(m_File, &FileStat) != 0)
+        {
+            Close();
+            return false;
+        }
+        m_Size = uint64_t(FileStat.st_size);
+#endif
+        return true;
+    }
+
+    // Reads up to Size bytes at Offset.  Returns the number of bytes read, or -1 on error.
+    int64_t Read(void* pDest, size_t Size, uint64_t Offset)
+    {
+#ifdef _WIN32
+        OVERLAPPED Overlapped = {};
+        Overlapped.Offset = DWORD(Offset);
+        Overlapped.OffsetHigh = DWORD(Offset >> 32);
+        DWORD BytesRead = 0;
+        DWORD ToRead = Size > 0x40000000 ? 0x40000000 : DWORD(Size);
+        if (!ReadFile(m_hFile, pDest, ToRead, &BytesRead, &Overlapped))
+        {
+            return GetLastError() == ERROR_HANDLE_EOF ? 0 : -1;
+        }
+        return int64_t(BytesRead);
+#else
+        ssize_t BytesRead;
+        do
+        {
+            BytesRead = pread(m_File, pDest, Size, off_t(Offset));
+        } while (BytesRead < 0 && errno == EINTR);
+        return int64_t(BytesRead);
+#endif
+    }
+
+    // Maps the whole file as it is now, which may be shorter than when it was opened.
+    // Returns null on failure or if the file is empty.
+    const uint8_t* Map()
+    {
+        if (m_pMapped)
+        {
+            return m_pMapped;
+        }
+#ifdef _WIN32
+        LARGE_INTEGER FileSize;
+        if (!GetFileSizeEx(m_hFile, &FileSize) || FileSize.QuadPart == 0)
+        {
+            return nullptr;
+        }
+        m_hMapping = CreateFileMappingA(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_hMapping)
+        {
+            m_pMapped = static_cast<const uint8_t*>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+        }
+        m_MappedSize = m_pMapped ? uint64_t(FileSize.QuadPart) : 0;
+#else
+        struct stat FileStat;
+        if (fstat(m_File, &FileStat) != 0 || FileStat.st_size == 0)
+        {
+            return nullptr;
+        }
+        void* pMapped = mmap(nullptr, size_t(FileStat.st_size), PROT_READ, MAP_PRIVATE, m_File, 0);
+        if (pMapped != MAP_FAILED)
+        {
+            m_pMapped = static_cast<const uint8_t*>(pMapped);
+            m_MappedSize = uint64_t(FileStat.st_size);
+        }
+#endif
+        return m_pMapped;
+    }
+
+    void Close()
+    {
+#ifdef _WIN32
+        if (m_pMapped)
+            UnmapViewOfFile(m_pMapped);
+        if (m_hMapping)
+            CloseHandle(m_hMapping);
+        if (m_hFile != INVALID_HANDLE_VALUE)
+            CloseHandle(m_hFile);
+        m_hMapping = nullptr;
+        m_hFile = INVALID_HANDLE_VALUE;
+#else
+        if (m_pMapped)
+            munmap(const_cast<uint8_t*>(m_pMapped), size_t(m_MappedSize));
+        if (m_File >= 0)
+            close(m_File);
+        m_File = -1;
+#endif
+        m_pMapped = nullptr;
+        m_MappedSize = 0;
+        m_Size = 0;
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+enum class StagingReadMode
+{
+    Read,       // Positional reads, falling back to MemoryMap if a read fails
+    MemoryMap,  // Copy from a mapping of the whole file
+};
+
+//------------------------------------------------------------------------------------------------
+// Chunk of a file staged by a TFileStagingPipeline
+struct StagedChunk
+{
+    const uint8_t* Data = nullptr;
+    size_t Size = 0;
+    uint64_t FileOffset = 0;
+};
+
+//------------------------------------------------------------------------------------------------
+// TFileStagingPipeline class
+//
+// Streams a file into a caller-owned staging buffer.  A reader thread reads the file in chunks
+// directly into space reserved from a TSpscByteChannel, which places records with a
+// TRingSuballocator, while the calling thread processes chunks that have already arrived.  Each
+// chunk's space is released as soon as the consumer is done with it, so reads overlap
+// processing and the buffer can be much smaller than the file.
+//
+// Every record holds a small header with the chunk's file offset and size, followed by the
+// data.  The constructor throws std::invalid_argument if ChunkSize is zero or the buffer has no
+// room for a header and at least one byte of data.
+//
+// Usage:
+//
+//   TFileStagingPipeline<uint32_t> Pipeline(pBuffer, BufferSize);
+//   Pipeline.Start("asset.bin");
+//   StagedChunk Chunk;
+//   while (Pipeline.AcquireChunk(Chunk))
+//   {
+//       Process(Chunk.Data, Chunk.Size, Chunk.FileOffset);
+//       Pipeline.ReleaseChunk();
+//   }
+//   bool Ok = !Pipeline.Failed();
+template<typename _IndexType>
+class TFileStagingPipeline
+{
+    struct ChunkHeader
+    {
+        uint64_t FileOffset;
+        uint64_t Size;
+    };
+
+    TSpscByteChannel<_IndexType> m_Channel;
+    size_t m_ChunkSize;
+    StagingReadMode m_Mode;
+    StagingFile m_File;
+    std::thread m_Reader;
+    std::atomic<bool> m_ReaderDone{ true };
+    std::atomic<bool> m_Failed{ false };
+    std::atomic<bool> m_Stop{ false };
+
+    // Fills pDest with Size bytes at Offset, switching to the mapping if a read fails
+    bool ReadChunk(uint8_t* pDest, size_t Size, uint64_t Offset)
+    {
+        while (m_Mode == StagingReadMode::Read && Size > 0)
+        {
+            int64_t BytesRead = m_File.Read(pDest, Size, Offset);
+            if (BytesRead <= 0)
+            {
+                m_Mode = StagingReadMode::MemoryMap;
+                break;
+            }
+
+            pDest += BytesRead;
+            Offset += uint64_t(BytesRead);
+            Size -= size_t(BytesRead);
+        }
+
+        if (Size > 0)
+        {
+            // The file may have shrunk since it was opened
+            const uint8_t* pMapped = m_File.Map();
+            if (!pMapped || Offset > m_File.MappedSize() || Size > m_File.MappedSize() - Offset)
+            {
+                return false;
+            }
+            memcpy(pDest, pMapped + Offset, Size);
+        }
+
+        return true;
+    }
+
+    void ReaderThread()
+    {
+        uint64_t FileSize = m_File.Size();
+        uint64_t Offset = 0;
+        while (Offset < FileSize && !m_Stop.load(std::memory_order_relaxed))
+        {
+            size_t Size = size_t((std::min)(uint64_t(m_ChunkSize), FileSize - Offset));
+            ByteSpan Span = m_Channel.BeginWrite(sizeof(ChunkHeader) + Size);
+            if (!Span.Data)
+            {
+                // Wait for the consumer to release space, publishing any wrap marker it must follow
+                m_Channel.Publish();
+                std::this_thread::yield();
+                continue;
+            }
+
+            if (!ReadChunk(Span.Data + sizeof(ChunkHeader), Size, Offset))
+            {
+                // Skip the reserved record so the next Start doesn't stream after a bogus header
+                m_Channel.CancelWrite();
+                m_Channel.Publish();
+                m_Failed.store(true, std::memory_order_relaxed);
+                break;
+            }
+
+            ChunkHeader Header = { Offset, Size };
+            memcpy(Span.Data, &Header, sizeof(Header));
+            m_Channel.EndWrite();
+            m_Channel.Publish();
+            Offset += Size;
+        }
+
+        m_ReaderDone.store(true, std::memory_order_release);
+    }
+
+public:
+    TFileStagingPipeline(void* pBuffer, size_t Size, size_t ChunkSize = 64 * 1024) :
+        m_Channel(pBuffer, Size),
+        m_ChunkSize(ChunkSize),
+        m_Mode(StagingReadMode::Read)
+    {
+        if (ChunkSize == 0 || m_Channel.MaxRecordSize() <= sizeof(ChunkHeader))
+        {
+            throw std::invalid_argument("The staging buffer cannot hold a chunk");
+        }
+
+        m_ChunkSize = (std::min)(ChunkSize, m_Channel.MaxRecordSize() - sizeof(ChunkHeader));
+    }
+
+    ~TFileStagingPipeline()
+    {
+        Stop();
+    }
+
+    // Non-copyable
+    TFileStagingPipeline(const TFileStagingPipeline&) = delete;
+    TFileStagingPipeline& operator=(const TFileStagingPipeline&) = delete;
+
+    size_t ChunkSize() const { return m_ChunkSize; }
+
+    // True if the file could not be read completely
+    bool Failed() const { return m_Failed.load(std::memory_order_acquire); }
+
+    // Opens a file and starts streaming it.  Returns false if the file cannot be opened.
+    bool Start(const char* pPath, StagingReadMode Mode = StagingReadMode::Read)
+    {
+        Stop();
+        if (!m_File.Open(pPath))
+        {
+            return false;
+        }
+
+        m_Mode = Mode;
+        m_Stop = false;
+        m_Failed = false;
+        m_ReaderDone = false;
+        m_Reader = std::thread(&TFileStagingPipeline::ReaderThread, this);
+        return true;
+    }
+
+    // Stops the reader thread and closes the file.  Unconsumed chunks are discarded.
+    void Stop()
+    {
+        m_Stop = true;
+        if (m_Reader.joinable())
+        {
+            m_Reader.join();
+        }
+
+        StagedChunk Chunk;
+        while (TryAcquireChunk(Chunk))
+        {
+            ReleaseChunk();
+        }
+        m_File.Close();
+    }
+
+    // Returns the next staged chunk, if one has arrived
+    bool TryAcquireChunk(StagedChunk& OutChunk)
+    {
+        ByteSpan Span = m_Channel.PeekRead();
+        if (!Span.Data)
+        {
+            return false;
+        }
+
+        ChunkHeader Header;
+        memcpy(&Header, Span.Data, sizeof(Header));
+        OutChunk.Data = Span.Data + sizeof(ChunkHeader);
+        OutChunk.Size = size_t(Header.Size);
+        OutChunk.FileOffset = Header.FileOffset;
+        return true;
+    }
+
+    // Waits for the next staged chunk.  Returns false once the whole file has been consumed or
+    // the reader has stopped.
+    bool AcquireChunk(StagedChunk& OutChunk)
+    {
+        for (;;)
+        {
+            if (TryAcquireChunk(OutChunk))
+            {
+                return true;
+            }
+
+            if (m_ReaderDone.load(std::memory_order_acquire))
+            {
+                // The reader may have published its last chunk before finishing
+                return TryAcquireChunk(OutChunk);
+            }
+
+            std::this_thread::yield();
+        }
+    }
+
+    // Releases the space of the chunk returned by the last acquire
+    void ReleaseChunk()
+    {
+        m_Channel.ConsumeRead();
+    }
+};
@@ -0,0 +1,156 @@
+//================================================================================================
+// LinearSuballocator
+//================================================================================================
+
+#pragma once
+
+#include <new>
+#include <stdexcept>
+
+//------------------------------------------------------------------------------------------------
+// TLinearSuballocator class
+//
+// Bump-pointer suballocator for scratch ranges with stack-like lifetimes.  Allocate advances a
+// single offset, GetMarker captures it, and RollbackTo releases every allocation made after the
+// marker in O(1).  Reset releases everything.
+//
+// Offsets returned by Allocate are relative to the allocation space, starting at BaseOffset.
+// Exhaustion throws std::bad_alloc.
+template<typename _IndexType>
+class TLinearSuballocator
+{
+    _IndexType m_BaseOffset = 0;
+    size_t m_Size = 0;
+    size_t m_Offset = 0;
+
+public:
+    TLinearSuballocator() = default;
+
+    TLinearSuballocator(size_t Size, _IndexType BaseOffset = 0) :
+        m_BaseOffset(BaseOffset),
+        m_Size(Size),
+        m_Offset(0) {}
+
+    size_t Capacity() const { return m_Size; }
+    size_t FreeSize() const { return m_Size - m_Offset; }
+    size_t AllocatedSize() const { return m_Offset; }
+
+    // Allocates Size units at an offset that is a multiple of Alignment.
+    // Any padding needed for alignment is consumed and released with the allocation.
+    _IndexType Allocate(size_t Size, size_t Alignment = 1)
+    {
+        if (Alignment == 0)
+        {
+            Alignment = 1;
+        }
+
+        size_t Base = size_t(m_BaseOffset);
+        size_t Start = ((Base + m_Offset + Alignment - 1) / Alignment) * Alignment - Base;
+        if (Start > m_Size || Size > m_Size - Start)
+        {
+            throw std::bad_alloc();
+        }
+
+        m_Offset = Start + Size;
+        return _IndexType(m_BaseOffset + Start);
+    }
+
+    // Non-throwing allocation: returns true on success, false if no space available
+    bool TryAllocate(size_t Size, size_t Alignment, _IndexType& OutOffset)
+    {
+        try
+        {
+            OutOffset = Allocate(Size, Alignment);
+            return true;
+        }
+        catch (const std::bad_alloc&)
+        {
+            return false;
+        }
+    }
+
+    // Returns a marker for the current allocation state
+    size_t GetMarker() const
+    {
+        return m_Offset;
+    }
+
+    // Releases all allocations made since Marker was obtained.
+    // Throws std::invalid_argument if Marker is beyond the current allocation state.
+    void RollbackTo(size_t Marker)
+    {
+        if (Marker > m_Offset)
+        {
+            throw std::invalid_argument("Marker is beyond the current allocation state");
+        }
+
+        m_Offset = Marker;
+    }
+
+    // Releases all allocations
+    void Reset()
+    {
+        m_Offset = 0;
+    }
+
+    // Releases all allocations and changes the size
+    void Reset(size_t Size)
+    {
+        m_Size = Size;
+        m_Offset = 0;
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// TDoubleBufferedLinearSuballocator class
+//
+// Pair of TLinearSuballocators over adjacent halves of the allocation space for work that
+// overlaps by one frame.  Allocations are made from the current frame's half.  NextFrame switches
+// to the other half and resets it, leaving the previous frame's allocations intact while they
+// are still in use.
+//
+// Frame 0 covers [0, SizePerFrame) and frame 1 covers [SizePerFrame, 2 * SizePerFrame).
+template<typename _IndexType>
+class TDoubleBufferedLinearSuballocator
+{
+    TLinearSuballocator<_IndexType> m_Frames[2];
+    unsigned m_CurrentFrame = 0;
+
+public:
+    TDoubleBufferedLinearSuballocator(size_t SizePerFrame) :
+        m_Frames{ TLinearSuballocator<_IndexType>(SizePerFrame, 0),
+                  TLinearSuballocator<_IndexType>(SizePerFrame, _IndexType(SizePerFrame)) } {}
+
+    unsigned CurrentFrameIndex() const { return m_CurrentFrame; }
+
+    TLinearSuballocator<_IndexType>& CurrentFrame() { return m_Frames[m_CurrentFrame]; }
+    const TLinearSuballocator<_IndexType>& CurrentFrame() const { return m_Frames[m_CurrentFrame]; }
+
+    _IndexType Allocate(size_t Size, size_t Alignment = 1)
+    {
+        return CurrentFrame().Allocate(Size, Alignment);
+    }
+
+    bool TryAllocate(size_t Size, size_t Alignment, _IndexType& OutOffset)
+    {
+        return CurrentFrame().TryAllocate(Size, Alignment, OutOffset);
+    }
+
+    size_t GetMarker() const { return CurrentFrame().GetMarker(); }
+    void RollbackTo(size_t Marker) { CurrentFrame().RollbackTo(Marker); }
+
+    // Switches to the other frame, releasing all allocations made the last time it was current
+    void NextFrame()
+    {
+        m_CurrentFrame ^= 1;
+        m_Frames[m_CurrentFrame].Reset();
+    }
+
+    // Releases the allocations of both frames
+    void Reset()
+    {
+        m_Frames[0].Reset();
+        m_Frames[1].Reset();
+        m_CurrentFrame = 0;
+    }
+};
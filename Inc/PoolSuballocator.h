@@ -0,0 +1,209 @@
+//================================================================================================
+// PoolSuballocator
+//================================================================================================
+
+#pragma once
+
+#include <new>
+#include <stdexcept>
+#include "BuddySuballocator.h"
+
+//------------------------------------------------------------------------------------------------
+// TPoolSuballocator class
+//
+// Manages allocation of uniformly sized logical ranges (slots).  Slot i covers the range
+// [i * SlotSize, (i + 1) * SlotSize).  Free slots are linked in a TIndexList whose nodes live in
+// an IndexNode table with one entry per slot, so Allocate and Free are O(1) list operations with
+// none of the order bookkeeping of TBuddySuballocator.
+//
+// Allocated slots are marked by storing an encoded value in their degenerate list node, which
+// lets Free reject offsets that are not allocated slots.
+//
+// Like TRingSuballocator, allocations are returned as offsets and exhaustion throws
+// std::bad_alloc.  Freeing an offset that is not an allocated slot throws std::invalid_argument.
+//
+// _IndexType is the type of integers representing the allocation space.
+template<class _IndexType>
+class TPoolSuballocator
+{
+    static_assert(_IndexType(-1) > _IndexType(0), "_IndexType must be an unsigned type");
+
+    using _IndexNodeType = IndexNode<_IndexType>;
+    using _IndexListType = TIndexList<_IndexType, _IndexNodeType*>;
+
+    static constexpr _IndexType _AllocatedValue = 1;
+    static constexpr _IndexType _PendingFreeValue = 2;
+
+    size_t m_SlotSize;
+    size_t m_NumSlots;
+    _IndexNodeType* m_Slots;
+    _IndexListType m_FreeSlots;
+
+    bool IsSlotAllocated(size_t Slot) const
+    {
+        return m_FreeSlots.GetEncodedValue(m_Slots, _IndexType(Slot)) == _AllocatedValue;
+    }
+
+    // Returns the slot for an offset, or m_NumSlots if the offset is not a slot boundary
+    size_t SlotFromOffset(_IndexType Offset) const
+    {
+        size_t Slot = size_t(Offset) / m_SlotSize;
+        return (Slot < m_NumSlots && Slot * m_SlotSize == size_t(Offset)) ? Slot : m_NumSlots;
+    }
+
+    // Links slots [First, Last) into the free list so that lower slots are allocated first
+    void AddFreeSlots(size_t First, size_t Last)
+    {
+        for (size_t Slot = Last; Slot > First; --Slot)
+        {
+            m_FreeSlots.PushFront(_IndexType(Slot - 1), m_Slots);
+        }
+    }
+
+    static void CheckCapacity(size_t NumSlots, size_t SlotSize)
+    {
+        if (NumSlots > 0 && (NumSlots * SlotSize - 1) > size_t(_IndexType(-1)))
+        {
+            throw std::bad_alloc();
+        }
+    }
+
+public:
+    TPoolSuballocator(size_t NumSlots, size_t SlotSize = 1) :
+        m_SlotSize(SlotSize ? SlotSize : 1),
+        m_NumSlots(NumSlots)
+    {
+        CheckCapacity(m_NumSlots, m_SlotSize);
+        m_Slots = new _IndexNodeType[m_NumSlots];
+        AddFreeSlots(0, m_NumSlots);
+    }
+
+    ~TPoolSuballocator()
+    {
+        delete[] m_Slots;
+    }
+
+    // Non-copyable
+    TPoolSuballocator(const TPoolSuballocator&) = delete;
+    TPoolSuballocator& operator=(const TPoolSuballocator&) = delete;
+
+    size_t SlotSize() const { return m_SlotSize; }
+    size_t SlotCount() const { return m_NumSlots; }
+    size_t FreeCount() const { return m_FreeSlots.Size(); }
+    size_t AllocatedCount() const { return m_NumSlots - m_FreeSlots.Size(); }
+
+    // Returns true if Offset is the start of an allocated slot
+    bool IsAllocated(_IndexType Offset) const
+    {
+        size_t Slot = SlotFromOffset(Offset);
+        return Slot < m_NumSlots && IsSlotAllocated(Slot);
+    }
+
+    // Allocates one slot and returns its offset
+    _IndexType Allocate()
+    {
+        if (m_FreeSlots.Size() == 0)
+        {
+            throw std::bad_alloc();
+        }
+
+        _IndexType Slot = m_FreeSlots.Begin().Index();
+        m_FreeSlots.PopFront(m_Slots);
+        m_FreeSlots.SetEncodedValue(m_Slots, Slot, _AllocatedValue);
+
+        return _IndexType(size_t(Slot) * m_SlotSize);
+    }
+
+    // Non-throwing allocation: returns true on success, false if no slot is available
+    bool TryAllocate(_IndexType& OutOffset)
+    {
+        if (m_FreeSlots.Size() == 0)
+        {
+            return false;
+        }
+
+        OutOffset = Allocate();
+        return true;
+    }
+
+    // Allocates Count slots, writing their offsets to pOutOffsets.
+    // Either all slots are allocated or, if fewer than Count are free, none are.
+    void AllocateBatch(size_t Count, _IndexType* pOutOffsets)
+    {
+        if (Count > m_FreeSlots.Size())
+        {
+            throw std::bad_alloc();
+        }
+
+        for (size_t i = 0; i < Count; ++i)
+        {
+            pOutOffsets[i] = Allocate();
+        }
+    }
+
+    // Non-throwing free: returns true if freed, false if Offset is not an allocated slot
+    bool TryFree(_IndexType Offset)
+    {
+        size_t Slot = SlotFromOffset(Offset);
+        if (Slot >= m_NumSlots || !IsSlotAllocated(Slot))
+        {
+            return false;
+        }
+
+        m_FreeSlots.PushFront(_IndexType(Slot), m_Slots);
+        return true;
+    }
+
+    void Free(_IndexType Offset)
+    {
+        if (!TryFree(Offset))
+        {
+            throw std::invalid_argument("Offset is not an allocated slot");
+        }
+    }
+
+    // Frees Count slots.  Throws std::invalid_argument, without freeing anything, if any offset is
+    // not an allocated slot or appears more than once.
+    void FreeBatch(const _IndexType* pOffsets, size_t Count)
+    {
+        // Validate and mark every slot first so that duplicates are detected
+        for (size_t i = 0; i < Count; ++i)
+        {
+            size_t Slot = SlotFromOffset(pOffsets[i]);
+            if (Slot >= m_NumSlots || !IsSlotAllocated(Slot))
+            {
+                // Undo the marks made so far
+                for (size_t j = 0; j < i; ++j)
+                {
+                    m_FreeSlots.SetEncodedValue(m_Slots, _IndexType(SlotFromOffset(pOffsets[j])), _AllocatedValue);
+                }
+
+                throw std::invalid_argument("Offset is not an allocated slot");
+            }
+
+            m_FreeSlots.SetEncodedValue(m_Slots, _IndexType(Slot), _PendingFreeValue);
+        }
+
+        for (size_t i = 0; i < Count; ++i)
+        {
+            m_FreeSlots.PushFront(_IndexType(SlotFromOffset(pOffsets[i])), m_Slots);
+        }
+    }
+
+    // Double the number of slots.  Existing slots keep their offsets.
+    void Grow()
+    {
+        size_t OldNumSlots = m_NumSlots;
+        size_t NewNumSlots = OldNumSlots ? OldNumSlots * 2 : 1;
+        CheckCapacity(NewNumSlots, m_SlotSize);
+
+        _IndexNodeType* pNewSlots = new _IndexNodeType[NewNumSlots];
+        for (size_t i = 0; i < OldNumSlots; ++i)
+            pNewSlots[i] = m_Slots[i];
+        delete[] m_Slots;
+        m_Slots = pNewSlots;
+        m_NumSlots = NewNumSlots;
+
+        AddFreeSlots(OldNumSlots, NewNumSlots);
+    }
+};
@@ -0,0 +1,449 @@
+//================================================================================================
+// QuadtreeSuballocator
+//================================================================================================
+
+#pragma once
+
+#include <cstdint>
+#include <new>
+#include "BuddySuballocator.h"
+
+//------------------------------------------------------------------------------------------------
+// Morton (Z-order) codes interleave the bits of X and Y, with X in the even bits.  An aligned
+// square of side 2^k covers a contiguous, aligned range of 4^k codes, so a quadtree maps onto a
+// 4-ary buddy tree over Morton order.
+inline uint64_t MortonSpreadBits(uint64_t Value)
+{
+    Value &= 0xffffffff;
+    Value = (Value | (Value << 16)) & 0x0000ffff0000ffff;
+    Value = (Value | (Value << 8)) & 0x00ff00ff00ff00ff;
+    Value = (Value | (Value << 4)) & 0x0f0f0f0f0f0f0f0f;
+    Value = (Value | (Value << 2)) & 0x3333333333333333;
+    Value = (Value | (Value << 1)) & 0x5555555555555555;
+    return Value;
+}
+
+inline uint64_t MortonCompactBits(uint64_t Value)
+{
+    Value &= 0x5555555555555555;
+    Value = (Value | (Value >> 1)) & 0x3333333333333333;
+    Value = (Value | (Value >> 2)) & 0x0f0f0f0f0f0f0f0f;
+    Value = (Value | (Value >> 4)) & 0x00ff00ff00ff00ff;
+    Value = (Value | (Value >> 8)) & 0x0000ffff0000ffff;
+    Value = (Value | (Value >> 16)) & 0x00000000ffffffff;
+    return Value;
+}
+
+inline uint64_t MortonEncode2D(uint32_t X, uint32_t Y)
+{
+    return MortonSpreadBits(X) | (MortonSpreadBits(Y) << 1);
+}
+
+inline void MortonDecode2D(uint64_t Code, uint32_t& X, uint32_t& Y)
+{
+    X = uint32_t(MortonCompactBits(Code));
+    Y = uint32_t(MortonCompactBits(Code >> 1));
+}
+
+//------------------------------------------------------------------------------------------------
+// Represents a square sub-allocation of a TQuadtreeSuballocator.
+// X and Y are the top-left corner.  Side is 2 ^ Order.
+template<typename _IndexType>
+class TQuadBlock
+{
+    _IndexType m_X;
+    _IndexType m_Y;
+    uint8_t m_Order;
+
+public:
+    TQuadBlock() :
+        m_X(0),
+        m_Y(0),
+        m_Order(static_cast<uint8_t>(-1)) {}
+
+    TQuadBlock(_IndexType X, _IndexType Y, uint8_t Order) :
+        m_X(X),
+        m_Y(Y),
+        m_Order(Order) {}
+
+    _IndexType X() const { return m_X; }
+    _IndexType Y() const { return m_Y; }
+    uint8_t Order() const { return m_Order; }
+    size_t Side() const { return m_Order == static_cast<uint8_t>(-1) ? 0 : size_t(1) << m_Order; }
+    size_t Area() const { return Side() * Side(); }
+
+    bool operator==(const TQuadBlock& o) const { return m_X == o.m_X && m_Y == o.m_Y && m_Order == o.m_Order; }
+    bool operator!=(const TQuadBlock& o) const { return !operator==(o); }
+};
+
+//------------------------------------------------------------------------------------------------
+// TQuadtreeSuballocator class
+//
+// Two-dimensional buddy allocator for packing rectangles into a square atlas.  Blocks are
+// power-of-two squares aligned to their own side, and a block splits into four quadrants.  A
+// rectangle is placed in the smallest square holding its longer side.
+//
+// Blocks are identified internally by the Morton code of their top-left corner, so the
+// quadrants of a block are four consecutive, equal ranges of codes and a block's code is the
+// code of its first quadrant.  As in TBuddySuballocator, free blocks are linked in per-order
+// free lists through an index table with one node per unit, and state bit arrays hold a split
+// bit and a free bit for every block in the tree:
+//
+// Level = MaxOrder - Order
+// StateIndex = (4 ^ Level - 1) / 3 + (Code >> (2 * Order))
+//
+// A freed block merges with its parent as soon as all four quadrants are free, so free space
+// always coalesces completely.  Allocate and Free take O(MaxOrder) time.
+//
+// The index table costs one IndexNode per unit of area, so for large atlases a unit should be
+// a tile of pixels (e.g. 8x8 or 16x16).  Every state index, which runs to about 4/3 of
+// Side * Side, must fit in _IndexType; the constructor and Grow throw std::bad_alloc otherwise.
+template<class _IndexType>
+class TQuadtreeSuballocator
+{
+    static_assert(_IndexType(-1) > _IndexType(0), "_IndexType must be an unsigned type");
+
+    using _IndexNodeType = IndexNode<_IndexType>;
+    using _IndexListType = TIndexList<_IndexType, _IndexNodeType *>;
+    using _BitArrayType = TBitArray<_IndexType>;
+
+    size_t m_Side;
+    uint8_t m_MaxOrder;
+    _IndexNodeType *m_AllocationTable; // One node per unit, indexed by Morton code
+    _IndexListType* m_FreeAllocations; // One free list per order
+    _BitArrayType m_SplitStateBitArray; // Set for blocks split into quadrants
+    _BitArrayType m_FreeStateBitArray; // Set for blocks currently linked in a free list
+
+    // Number of blocks in a tree of the given max order
+    static size_t StateCount(uint8_t MaxOrder)
+    {
+        return ((size_t(1) << (2 * (MaxOrder + 1))) - 1) / 3;
+    }
+
+    // Throws std::bad_alloc if a tree of the given max order can't be indexed by _IndexType.
+    // Morton codes are below the state count, so they never reach the list terminator.
+    static uint8_t CheckMaxOrder(uint8_t MaxOrder)
+    {
+        if (MaxOrder > 30 || StateCount(MaxOrder) - 1 > size_t(_IndexType(-1)))
+        {
+            throw std::bad_alloc();
+        }
+
+        return MaxOrder;
+    }
+
+    static size_t BlockArea(uint8_t Order)
+    {
+        return size_t(1) << (2 * Order);
+    }
+
+    _IndexType StateIndex(_IndexType Code, uint8_t Order) const
+    {
+        uint8_t Level = m_MaxOrder - Order;
+        return _IndexType((BlockArea(Level) - 1) / 3 + (size_t(Code) >> (2 * Order)));
+    }
+
+    static _IndexType BlockCode(const TQuadBlock<_IndexType>& Block)
+    {
+        return _IndexType(MortonEncode2D(uint32_t(Block.X()), uint32_t(Block.Y())));
+    }
+
+    static TQuadBlock<_IndexType> CodeBlock(_IndexType Code, uint8_t Order)
+    {
+        uint32_t X, Y;
+        MortonDecode2D(Code, X, Y);
+        return TQuadBlock<_IndexType>(_IndexType(X), _IndexType(Y), Order);
+    }
+
+    // Returns true if the block lies within the atlas and is aligned to its own side
+    bool IsValidBlock(const TQuadBlock<_IndexType>& Block) const
+    {
+        size_t Side = Block.Side();
+        return Block.Order() <= m_MaxOrder && size_t(Block.X()) + Side <= m_Side && size_t(Block.Y()) + Side <= m_Side &&
+            (size_t(Block.X()) & (Side - 1)) == 0 && (size_t(Block.Y()) & (Side - 1)) == 0;
+    }
+
+    bool IsAllocated(_IndexType Code, uint8_t Order) const
+    {
+        return _IndexType(Order + 1) == m_FreeAllocations->GetEncodedValue(m_AllocationTable, Code);
+    }
+
+    bool IsFree(_IndexType Code, uint8_t Order) const
+    {
+        return m_FreeStateBitArray[StateIndex(Code, Order)];
+    }
+
+    void TrackNodeAsAllocated(_IndexType Code, uint8_t Order)
+    {
+        // Encode the node with 1 + allocation order
+        m_FreeAllocations->SetEncodedValue(m_AllocationTable, Code, _IndexType(Order + 1));
+    }
+
+    void UntrackNode(_IndexType Code)
+    {
+        // Degenerate the node by indexing self, clearing any allocation encoding
+        m_AllocationTable[Code].Prev = Code;
+        m_AllocationTable[Code].Next = Code;
+    }
+
+    void PushFreeBlock(_IndexType Code, uint8_t Order)
+    {
+        m_FreeAllocations[Order].PushFront(Code, m_AllocationTable);
+        m_FreeStateBitArray.Set(StateIndex(Code, Order), true);
+    }
+
+    void RemoveFreeBlock(_IndexType Code, uint8_t Order)
+    {
+        m_FreeAllocations[Order].Remove(Code, m_AllocationTable);
+        m_FreeStateBitArray.Set(StateIndex(Code, Order), false);
+    }
+
+    // Pushes quadrants 3, 2 and 1 of a block, so quadrant 1 is allocated next and blocks fill in
+    // Z order
+    void PushUpperQuadrants(_IndexType Code, uint8_t QuadrantOrder)
+    {
+        for (size_t Quadrant = 3; Quadrant >= 1; --Quadrant)
+        {
+            PushFreeBlock(_IndexType(Code + Quadrant * BlockArea(QuadrantOrder)), QuadrantOrder);
+        }
+    }
+
+    _IndexType AllocateImpl(uint8_t Order)
+    {
+        if (Order > m_MaxOrder)
+        {
+            throw(BuddySuballocatorException(BuddySuballocatorException::Type::Unavailable));
+        }
+
+        if (m_FreeAllocations[Order].Size())
+        {
+            _IndexType Code = m_FreeAllocations[Order].Begin().Index();
+            RemoveFreeBlock(Code, Order);
+            TrackNodeAsAllocated(Code, Order);
+            return Code;
+        }
+
+        // Split a parent block, keeping the first quadrant
+        _IndexType Code = AllocateImpl(Order + 1);
+        PushUpperQuadrants(Code, Order);
+        m_SplitStateBitArray.Set(StateIndex(Code, Order + 1), true);
+        TrackNodeAsAllocated(Code, Order);
+        return Code;
+    }
+
+    void FreeImpl(_IndexType Code, uint8_t Order)
+    {
+        for (; Order < m_MaxOrder; ++Order)
+        {
+            _IndexType ParentCode = _IndexType(size_t(Code) & ~(BlockArea(Order + 1) - 1));
+            for (size_t Quadrant = 0; Quadrant < 4; ++Quadrant)
+            {
+                _IndexType Sibling = _IndexType(ParentCode + Quadrant * BlockArea(Order));
+                if (Sibling != Code && !IsFree(Sibling, Order))
+                {
+                    PushFreeBlock(Code, Order);
+                    return;
+                }
+            }
+
+            // All four quadrants are free; merge them into the parent
+            for (size_t Quadrant = 0; Quadrant < 4; ++Quadrant)
+            {
+                _IndexType Sibling = _IndexType(ParentCode + Quadrant * BlockArea(Order));
+                if (Sibling != Code)
+                {
+                    RemoveFreeBlock(Sibling, Order);
+                }
+            }
+
+            UntrackNode(Code);
+            m_SplitStateBitArray.Set(StateIndex(ParentCode, Order + 1), false);
+            Code = ParentCode;
+        }
+
+        PushFreeBlock(Code, Order);
+    }
+
+public:
+    // Side is rounded up to a power of two.  Throws std::bad_alloc if it is too large for
+    // _IndexType.
+    TQuadtreeSuballocator(size_t Side) :
+        m_MaxOrder(CheckMaxOrder((uint8_t)Log2Ceil(Side))),
+        m_SplitStateBitArray(StateCount(m_MaxOrder)),
+        m_FreeStateBitArray(StateCount(m_MaxOrder))
+    {
+        m_Side = size_t(1) << m_MaxOrder;
+        m_AllocationTable = new _IndexNodeType[m_Side * m_Side];
+        m_FreeAllocations = new _IndexListType[m_MaxOrder + 1];
+
+        // Zeroed nodes other than node 0 would decode as allocation encodings
+        for (size_t i = 0; i < m_Side * m_Side; ++i)
+        {
+            UntrackNode(_IndexType(i));
+        }
+
+        PushFreeBlock(0, m_MaxOrder);
+    }
+
+    ~TQuadtreeSuballocator()
+    {
+        delete[] m_AllocationTable;
+        delete[] m_FreeAllocations;
+    }
+
+    // Non-copyable
+    TQuadtreeSuballocator(const TQuadtreeSuballocator&) = delete;
+    TQuadtreeSuballocator& operator=(const TQuadtreeSuballocator&) = delete;
+
+    size_t GetSide() const { return m_Side; }
+    uint8_t GetMaxOrder() const { return m_MaxOrder; }
+
+    // Allocates the smallest square block holding a Width x Height rectangle
+    TQuadBlock<_IndexType> Allocate(size_t Width, size_t Height)
+    {
+        uint8_t Order = (uint8_t) Log2Ceil((std::max)(Width, Height));
+        return CodeBlock(AllocateImpl(Order), Order);
+    }
+
+    // Non-throwing allocation: returns true on success, false if no space available
+    bool TryAllocate(size_t Width, size_t Height, TQuadBlock<_IndexType>& OutBlock)
+    {
+        try
+        {
+            OutBlock = Allocate(Width, Height);
+            return true;
+        }
+        catch (BuddySuballocatorException&)
+        {
+            return false;
+        }
+    }
+
+    void Free(const TQuadBlock<_IndexType>& Block)
+    {
+        if (!IsBlockAllocated(Block))
+        {
+            throw(BuddySuballocatorException(BuddySuballocatorException::Type::NotAllocated));
+        }
+
+        FreeImpl(BlockCode(Block), Block.Order());
+    }
+
+    // Non-throwing free: returns true if freed, false if block was not allocated
+    bool TryFree(const TQuadBlock<_IndexType>& Block)
+    {
+        if (!IsBlockAllocated(Block))
+            return false;
+        FreeImpl(BlockCode(Block), Block.Order());
+        return true;
+    }
+
+    // Returns true if the block is currently allocated
+    bool IsBlockAllocated(const TQuadBlock<_IndexType>& Block) const
+    {
+        return IsValidBlock(Block) && IsAllocated(BlockCode(Block), Block.Order());
+    }
+
+    // Returns true if the block is linked in a free list, as opposed to lying within a larger
+    // free block
+    bool IsBlockFree(const TQuadBlock<_IndexType>& Block) const
+    {
+        return IsValidBlock(Block) && IsFree(BlockCode(Block), Block.Order());
+    }
+
+    // Doubles the side of the atlas.  Existing allocations keep their coordinates: the old tree
+    // becomes the top-left quadrant of a new root and the other three quadrants are free.
+    // Throws std::bad_alloc, leaving the atlas unchanged, if the larger tree can't be indexed by
+    // _IndexType.
+    void Grow()
+    {
+        CheckMaxOrder(m_MaxOrder + 1);
+
+        size_t OldSide = m_Side;
+        uint8_t OldMaxOrder = m_MaxOrder;
+        size_t OldArea = OldSide * OldSide;
+        uint8_t NewMaxOrder = OldMaxOrder + 1;
+        size_t NewArea = OldArea * 4;
+
+        // Morton codes don't depend on the atlas size, so existing nodes keep their indices
+        _IndexNodeType* pNewTable = new _IndexNodeType[NewArea];
+        for (size_t i = 0; i < OldArea; ++i)
+            pNewTable[i] = m_AllocationTable[i];
+        delete[] m_AllocationTable;
+        m_AllocationTable = pNewTable;
+        for (size_t i = OldArea; i < NewArea; ++i)
+            UntrackNode(_IndexType(i));
+
+        _IndexListType* pNewFreeLists = new _IndexListType[NewMaxOrder + 1];
+        for (uint8_t o = 0; o <= OldMaxOrder; ++o)
+            pNewFreeLists[o] = std::move(m_FreeAllocations[o]);
+        delete[] m_FreeAllocations;
+        m_FreeAllocations = pNewFreeLists;
+
+        // Every old level moves down one level, so its state indices start at the next level's
+        // offset while keeping their position within the level
+        _BitArrayType NewSplitBitArray(StateCount(NewMaxOrder));
+        _BitArrayType NewFreeBitArray(StateCount(NewMaxOrder));
+        for (uint8_t OldLevel = 0; OldLevel <= OldMaxOrder; ++OldLevel)
+        {
+            size_t OldLevelStart = (BlockArea(OldLevel) - 1) / 3;
+            size_t NewLevelStart = (BlockArea(OldLevel + 1) - 1) / 3;
+            for (size_t i = 0; i < BlockArea(OldLevel); ++i)
+            {
+                if (m_SplitStateBitArray[_IndexType(OldLevelStart + i)])
+                    NewSplitBitArray.Set(_IndexType(NewLevelStart + i), true);
+                if (m_FreeStateBitArray[_IndexType(OldLevelStart + i)])
+                    NewFreeBitArray.Set(_IndexType(NewLevelStart + i), true);
+            }
+        }
+        m_SplitStateBitArray = std::move(NewSplitBitArray);
+        m_FreeStateBitArray = std::move(NewFreeBitArray);
+
+        m_Side = OldSide * 2;
+        m_MaxOrder = NewMaxOrder;
+
+        if (m_FreeAllocations[OldMaxOrder].Size() > 0)
+        {
+            // The old tree is entirely free, so the whole atlas is one free block
+            RemoveFreeBlock(0, OldMaxOrder);
+            PushFreeBlock(0, NewMaxOrder);
+        }
+        else
+        {
+            m_SplitStateBitArray.Set(StateIndex(0, NewMaxOrder), true);
+            PushUpperQuadrants(0, OldMaxOrder);
+        }
+    }
+
+    // Total free area in units, in O(MaxOrder) time
+    size_t TotalFreeArea() const
+    {
+        size_t TotalFree = 0;
+        for (uint8_t Order = 0; Order <= m_MaxOrder; ++Order)
+        {
+            TotalFree += m_FreeAllocations[Order].Size() * BlockArea(Order);
+        }
+
+        return TotalFree;
+    }
+
+    // Side of the largest square that can currently be allocated, or 0 if the atlas is full
+    size_t MaxAllocationSide() const
+    {
+        for (int Order = m_MaxOrder; Order >= 0; Order--)
+        {
+            if (m_FreeAllocations[Order].Size() != 0)
+            {
+                return size_t(1) << Order;
+            }
+        }
+
+        return 0;
+    }
+
+    // Number of free blocks of the given order
+    size_t FreeBlockCount(uint8_t Order) const
+    {
+        return Order <= m_MaxOrder ? m_FreeAllocations[Order].Size() : 0;
+    }
+};
@@ -4,22 +4,103 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <new>
+
+//------------------------------------------------------------------------------------------------
+// TRingSuballocator class
+//
+// Allocates ranges in FIFO order from a circular allocation space.  Free releases the oldest
+// allocated units first.
+//
+// By default an allocation may straddle the end of the allocation space and continue at offset
+// 0.  In contiguous mode, a request that would straddle the end is placed at offset 0 instead,
+// and the skipped tail is consumed as padding.  Alignment padding is consumed the same way.
+// Padding is reclaimed automatically once Free reaches it, so callers only free the sizes they
+// requested.  AllocatedSize includes any padding not yet reclaimed.
+//
+// Instead of freeing sizes explicitly, allocations can be grouped into frames tagged with a
+// fence value using EndFrame.  Retire(CompletedFence) then frees every frame whose fence has
+// completed.  Fence values must be passed to EndFrame in nondecreasing order.
 template<typename _IndexType>
 class TRingSuballocator
 {
+    struct Padding
+    {
+        size_t Begin; // Value of m_TotalAllocated where the padding starts
+        size_t Size;
+    };
+
+    struct Frame
+    {
+        uint64_t Fence;
+        size_t End; // Value of m_TotalAllocated at the end of the frame
+    };
+
     _IndexType m_Start = 0;
     _IndexType m_End = 0;
     size_t m_Size = 0;
     size_t m_FreeSize = 0;
+    bool m_Contiguous = false;
+
+    // Monotonic counts of units allocated and freed, used to locate padding
+    size_t m_TotalAllocated = 0;
+    size_t m_TotalFreed = 0;
+    std::deque<Padding> m_Padding;
+    size_t m_PaddingSize = 0;
+    std::deque<Frame> m_Frames;
+
+    void Release(size_t Size)
+    {
+        m_FreeSize += Size;
+        m_TotalFreed += Size;
+        m_Start = _IndexType((m_Start + Size) % m_Size);
+    }
+
+    // Reclaims any padding at the start of the allocated range
+    void ReclaimPadding()
+    {
+        while (!m_Padding.empty() && m_Padding.front().Begin == m_TotalFreed)
+        {
+            Release(m_Padding.front().Size);
+            m_PaddingSize -= m_Padding.front().Size;
+            m_Padding.pop_front();
+        }
+    }
+
+    // Frees all units allocated before m_TotalAllocated reached End
+    void ReleaseTo(size_t End)
+    {
+        if (End <= m_TotalFreed)
+        {
+            return;
+        }
+
+        Release(End - m_TotalFreed);
+        while (!m_Padding.empty() && m_Padding.front().Begin < End)
+        {
+            m_PaddingSize -= m_Padding.front().Size;
+            m_Padding.pop_front();
+        }
+        ReclaimPadding();
+    }
 
 public:
     TRingSuballocator() = default;
 
-    TRingSuballocator(size_t Size) :
+    TRingSuballocator(size_t Size, bool Contiguous = false) :
         m_Start(0),
         m_End(0),
         m_Size(Size),
-        m_FreeSize(Size) {}
+        m_FreeSize(Size),
+        m_Contiguous(Contiguous) {}
+
+    bool IsContiguous() const
+    {
+        return m_Contiguous;
+    }
 
     size_t FreeSize() const
     {
@@ -31,28 +112,137 @@ public:
         return m_Size - m_FreeSize;
     }
 
-    _IndexType Allocate(size_t Size)
+    // Portion of AllocatedSize consumed by padding
+    size_t PaddingSize() const
+    {
+        return m_PaddingSize;
+    }
+
+    // Offset of the oldest allocated unit that is not padding.  Equals the offset of the next
+    // allocation if nothing but padding is allocated.
+    _IndexType OldestOffset() const
     {
-        _IndexType Loc = m_End;
-        if(Size > m_FreeSize)
+        size_t Start = size_t(m_Start);
+        size_t Freed = m_TotalFreed;
+        for (const auto& Pad : m_Padding)
+        {
+            if (Pad.Begin != Freed)
+            {
+                break;
+            }
+            Start += Pad.Size;
+            Freed += Pad.Size;
+        }
+
+        return m_Size ? _IndexType(Start % m_Size) : _IndexType(0);
+    }
+
+    // Allocates Size units at an offset that is a multiple of Alignment.
+    // Throws std::bad_alloc if the request, including any padding, does not fit.
+    _IndexType Allocate(size_t Size, size_t Alignment = 1)
+    {
+        if (Alignment == 0)
+        {
+            Alignment = 1;
+        }
+
+        if (m_FreeSize == m_Size)
+        {
+            // Nothing is allocated, so a contiguous request can start over at offset 0
+            if (m_Contiguous && m_End != 0 && Size > m_Size - m_End)
+            {
+                m_Start = 0;
+                m_End = 0;
+            }
+        }
+
+        size_t End = size_t(m_End);
+        size_t Loc = ((End + Alignment - 1) / Alignment) * Alignment;
+        if (Loc >= m_Size || (m_Contiguous && Size > m_Size - Loc))
+        {
+            // Skip the tail and continue at offset 0
+            Loc = m_Size;
+        }
+
+        size_t Pad = Loc - End;
+        if (Size > m_FreeSize || Pad > m_FreeSize - Size)
         {
             throw std::bad_alloc();
         }
 
-        m_FreeSize -= Size;
-        m_End = _IndexType((m_End + Size) % m_Size);
-        return Loc;
+        if (Pad)
+        {
+            m_Padding.push_back({ m_TotalAllocated, Pad });
+            m_PaddingSize += Pad;
+        }
+
+        m_FreeSize -= Pad + Size;
+        m_TotalAllocated += Pad + Size;
+        m_End = _IndexType((Loc + Size) % m_Size);
+        return _IndexType(Loc % m_Size);
     }
 
+    // Non-throwing allocation: returns true on success, false if no space available
+    bool TryAllocate(size_t Size, size_t Alignment, _IndexType& OutOffset)
+    {
+        try
+        {
+            OutOffset = Allocate(Size, Alignment);
+            return true;
+        }
+        catch (const std::bad_alloc&)
+        {
+            return false;
+        }
+    }
+
+    // Frees the oldest Size allocated units, along with any padding reached along the way.
+    // Freeing several allocations at once is equivalent to freeing them one at a time.
     void Free(size_t Size)
     {
-        if(Size > AllocatedSize())
+        ReclaimPadding();
+        while (Size && m_FreeSize < m_Size)
         {
-            Size = AllocatedSize();
+            size_t Run = (std::min)(Size, AllocatedSize());
+            if (!m_Padding.empty())
+            {
+                Run = (std::min)(Run, m_Padding.front().Begin - m_TotalFreed);
+            }
+
+            Release(Run);
+            Size -= Run;
+            ReclaimPadding();
         }
-        
-        m_FreeSize += Size;
-        m_Start = _IndexType((m_Start + Size) % m_Size);
+    }
+
+    // Tags all units allocated since the previous frame with Fence
+    void EndFrame(uint64_t Fence)
+    {
+        size_t FrameStart = m_Frames.empty() ? m_TotalFreed : (std::max)(m_Frames.back().End, m_TotalFreed);
+        if (m_TotalAllocated > FrameStart)
+        {
+            m_Frames.push_back({ Fence, m_TotalAllocated });
+        }
+    }
+
+    // Frees the units of every frame whose fence is at most CompletedFence.
+    // Returns the number of units released, including padding.
+    size_t Retire(uint64_t CompletedFence)
+    {
+        size_t FreeSize = m_FreeSize;
+        while (!m_Frames.empty() && m_Frames.front().Fence <= CompletedFence)
+        {
+            ReleaseTo(m_Frames.front().End);
+            m_Frames.pop_front();
+        }
+
+        return m_FreeSize - FreeSize;
+    }
+
+    // Number of frames waiting for their fence to complete
+    size_t PendingFrameCount() const
+    {
+        return m_Frames.size();
     }
 
     void Reset(size_t Size)
@@ -61,5 +251,191 @@ public:
         m_FreeSize = Size;
         m_Start = 0;
         m_End = 0;
+        m_TotalAllocated = 0;
+        m_TotalFreed = 0;
+        m_Padding.clear();
+        m_PaddingSize = 0;
+        m_Frames.clear();
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// Location of an allocation made by a TChainedRingSuballocator
+template<typename _IndexType>
+struct TRingAllocation
+{
+    uint32_t Segment = 0;
+    _IndexType Offset = 0;
+
+    bool operator==(const TRingAllocation& o) const { return Segment == o.Segment && Offset == o.Offset; }
+    bool operator!=(const TRingAllocation& o) const { return !operator==(o); }
+};
+
+//------------------------------------------------------------------------------------------------
+// TChainedRingSuballocator class
+//
+// Ring suballocator that grows instead of failing.  When the current segment cannot satisfy a
+// request, a new segment of at least twice the size is chained after it, and all further
+// allocations are made from the new segment.  Frees and retirements proceed in FIFO order
+// through the older segments.  Each older segment is released once it drains, so the chain
+// collapses back to a single ring after a burst.
+//
+// Allocations are identified by segment id and offset within the segment.  Segment ids increase
+// monotonically, so callers can map each id to backing memory.  Every segment with an id below
+// OldestSegment() has been released.
+//
+// Frames behave as in TRingSuballocator and may span segments.
+template<typename _IndexType>
+class TChainedRingSuballocator
+{
+    struct Segment
+    {
+        uint32_t Id;
+        TRingSuballocator<_IndexType> Ring;
+    };
+
+    bool m_Contiguous;
+    uint32_t m_NextSegmentId = 0;
+    std::deque<Segment> m_Segments;
+
+    void AddSegment(size_t Size)
+    {
+        m_Segments.push_back({ m_NextSegmentId++, TRingSuballocator<_IndexType>(Size, m_Contiguous) });
+    }
+
+    // Releases drained segments other than the current one
+    void ReleaseDrainedSegments()
+    {
+        while (m_Segments.size() > 1 && m_Segments.front().Ring.AllocatedSize() == 0)
+        {
+            m_Segments.pop_front();
+        }
+    }
+
+public:
+    TChainedRingSuballocator(size_t Size, bool Contiguous = false) :
+        m_Contiguous(Contiguous)
+    {
+        AddSegment(Size);
+    }
+
+    bool IsContiguous() const { return m_Contiguous; }
+    size_t SegmentCount() const { return m_Segments.size(); }
+    uint32_t OldestSegment() const { return m_Segments.front().Id; }
+    uint32_t CurrentSegment() const { return m_Segments.back().Id; }
+
+    // Returns the size of a live segment, or 0 if the segment has been released
+    size_t GetSegmentSize(uint32_t Id) const
+    {
+        if (Id < OldestSegment() || Id > CurrentSegment())
+        {
+            return 0;
+        }
+
+        return m_Segments[Id - OldestSegment()].Ring.FreeSize() + m_Segments[Id - OldestSegment()].Ring.AllocatedSize();
+    }
+
+    size_t FreeSize() const
+    {
+        return m_Segments.back().Ring.FreeSize();
+    }
+
+    size_t AllocatedSize() const
+    {
+        size_t Size = 0;
+        for (auto& Seg : m_Segments)
+        {
+            Size += Seg.Ring.AllocatedSize();
+        }
+        return Size;
+    }
+
+    // Allocates Size units at an offset that is a multiple of Alignment, chaining a new segment
+    // if the current one is full.  Throws std::bad_alloc only if the new segment would exceed the
+    // range of _IndexType.
+    TRingAllocation<_IndexType> Allocate(size_t Size, size_t Alignment = 1)
+    {
+        _IndexType Offset;
+        if (!m_Segments.back().Ring.TryAllocate(Size, Alignment, Offset))
+        {
+            size_t CurrentSize = GetSegmentSize(CurrentSegment());
+            size_t NewSize = CurrentSize ? CurrentSize * 2 : 1;
+            while (NewSize < Size)
+            {
+                NewSize *= 2;
+            }
+
+            if (NewSize - 1 > size_t(_IndexType(-1)))
+            {
+                throw std::bad_alloc();
+            }
+
+            AddSegment(NewSize);
+            ReleaseDrainedSegments();
+            Offset = m_Segments.back().Ring.Allocate(Size, Alignment);
+        }
+
+        return TRingAllocation<_IndexType>{ CurrentSegment(), Offset };
+    }
+
+    // Non-throwing allocation: returns true on success, false if the chain cannot grow
+    bool TryAllocate(size_t Size, size_t Alignment, TRingAllocation<_IndexType>& OutAllocation)
+    {
+        try
+        {
+            OutAllocation = Allocate(Size, Alignment);
+            return true;
+        }
+        catch (const std::bad_alloc&)
+        {
+            return false;
+        }
+    }
+
+    // Frees the oldest Size allocated units across segments, oldest segment first
+    void Free(size_t Size)
+    {
+        for (auto& Seg : m_Segments)
+        {
+            size_t Run = (std::min)(Size, Seg.Ring.AllocatedSize() - Seg.Ring.PaddingSize());
+            Seg.Ring.Free(Run);
+            Size -= Run;
+            if (Size == 0)
+            {
+                break;
+            }
+        }
+
+        ReleaseDrainedSegments();
+    }
+
+    // Tags all units allocated since the previous frame with Fence
+    void EndFrame(uint64_t Fence)
+    {
+        for (auto& Seg : m_Segments)
+        {
+            Seg.Ring.EndFrame(Fence);
+        }
+    }
+
+    // Frees the units of every frame whose fence is at most CompletedFence.
+    // Returns the number of units released, including padding.
+    size_t Retire(uint64_t CompletedFence)
+    {
+        size_t Released = 0;
+        for (auto& Seg : m_Segments)
+        {
+            Released += Seg.Ring.Retire(CompletedFence);
+        }
+
+        ReleaseDrainedSegments();
+        return Released;
+    }
+
+    // Releases all segments and restarts with a single segment of the given size
+    void Reset(size_t Size)
+    {
+        m_Segments.clear();
+        AddSegment(Size);
     }
-};
\ No newline at end of file
+};
@@ -0,0 +1,248 @@
+//================================================================================================
+// ShardedBuddySuballocator
+//================================================================================================
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include "BuddySuballocator.h"
+
+//------------------------------------------------------------------------------------------------
+// TShardedBuddySuballocator class
+//
+// Thread-safe buddy allocator that splits its capacity into equal shards, each a separate
+// TBuddySuballocator with its own lock.  Shard i covers [i * ShardSize, (i + 1) * ShardSize), so
+// threads allocating from different home shards (e.g. one per core) don't contend.
+//
+// When the home shard can't satisfy a request, a block is stolen from another shard: the shard
+// advertising the largest free block is tried first, then every other shard in turn.  Victims
+// are picked from each shard's published statistics snapshot, so picking one takes no locks.
+// A stolen block stays owned by the shard whose range holds it, and Free routes every block to
+// its shard with Start >> ShardOrder.
+//
+// Requests larger than ShardSize fail.  ShardSize must be a power of two and the capacity must be
+// addressable by _IndexType; the constructor throws std::invalid_argument otherwise.  Statistics
+// are aggregated from the shards' snapshots without locking, so they are exact only when no
+// other thread is active.
+template<class _IndexType>
+class TShardedBuddySuballocator
+{
+    static constexpr size_t _CacheLineSize = 64;
+
+    struct alignas(_CacheLineSize) Shard
+    {
+        std::mutex Mutex;
+        std::unique_ptr<TBuddySuballocator<_IndexType>> pAllocator;
+    };
+
+    size_t m_ShardSize;
+    uint8_t m_ShardOrder;
+    size_t m_ShardCount;
+    std::unique_ptr<Shard[]> m_Shards;
+    std::atomic<size_t> m_StealCount{ 0 };
+
+    bool TryAllocateFromShard(size_t Index, size_t Size, TBuddyBlock<_IndexType>& OutBlock)
+    {
+        Shard& S = m_Shards[Index];
+        std::lock_guard<std::mutex> Lock(S.Mutex);
+        TBuddyBlock<_IndexType> Block;
+        if (!S.pAllocator->TryAllocate(Size, Block))
+        {
+            return false;
+        }
+
+        OutBlock = TBuddyBlock<_IndexType>(_IndexType(Index * m_ShardSize + Block.Start()), Block.Order());
+        return true;
+    }
+
+    // Returns the shard owning Block and the block relative to that shard.
+    // Throws NotAllocated if the block lies outside every shard.
+    Shard& LocateBlock(const TBuddyBlock<_IndexType>& Block, TBuddyBlock<_IndexType>& OutLocalBlock) const
+    {
+        size_t Index = size_t(Block.Start()) >> m_ShardOrder;
+        if (Index >= m_ShardCount || Block.Order() > m_ShardOrder)
+        {
+            throw(BuddySuballocatorException(BuddySuballocatorException::Type::NotAllocated));
+        }
+
+        OutLocalBlock = TBuddyBlock<_IndexType>(_IndexType(size_t(Block.Start()) - Index * m_ShardSize), Block.Order());
+        return m_Shards[Index];
+    }
+
+public:
+    TShardedBuddySuballocator(size_t ShardSize, size_t ShardCount) :
+        m_ShardSize(ShardSize),
+        m_ShardOrder((uint8_t)Log2Ceil(ShardSize)),
+        m_ShardCount(ShardCount),
+        m_Shards(new Shard[ShardCount])
+    {
+        // Placement multiplies by ShardSize while routing shifts by ShardOrder, so they agree
+        // only for powers of two
+        if (ShardSize == 0 || (ShardSize & (ShardSize - 1)) != 0)
+        {
+            throw std::invalid_argument("ShardSize must be a nonzero power of two");
+        }
+
+        size_t MaxIndex = size_t(_IndexType(-1));
+        if (ShardCount == 0 || ShardSize - 1 > MaxIndex || ShardCount - 1 > MaxIndex / ShardSize)
+        {
+            throw std::invalid_argument("ShardSize * ShardCount must be nonzero and addressable by _IndexType");
+        }
+
+        for (size_t i = 0; i < m_ShardCount; ++i)
+        {
+            m_Shards[i].pAllocator.reset(new TBuddySuballocator<_IndexType>(ShardSize));
+        }
+    }
+
+    // Non-copyable
+    TShardedBuddySuballocator(const TShardedBuddySuballocator&) = delete;
+    TShardedBuddySuballocator& operator=(const TShardedBuddySuballocator&) = delete;
+
+    size_t GetCapacity() const { return m_ShardSize * m_ShardCount; }
+    size_t GetShardSize() const { return m_ShardSize; }
+    size_t ShardCount() const { return m_ShardCount; }
+
+    // Index of the shard whose range holds Offset
+    size_t ShardOf(size_t Offset) const { return Offset >> m_ShardOrder; }
+
+    // Number of allocations served by a shard other than the requested home shard
+    size_t StealCount() const { return m_StealCount.load(std::memory_order_relaxed); }
+
+    // Allocates from HomeShard, stealing from another shard if the home shard is out of space.
+    // HomeShard is taken modulo ShardCount.
+    TBuddyBlock<_IndexType> Allocate(size_t Size, size_t HomeShard)
+    {
+        HomeShard %= m_ShardCount;
+        TBuddyBlock<_IndexType> Block;
+        if (TryAllocateFromShard(HomeShard, Size, Block))
+        {
+            return Block;
+        }
+
+        // The victim with the largest free block is least likely to fail or fragment
+        size_t BlockSize = size_t(1) << Log2Ceil(Size);
+        size_t Victim = HomeShard;
+        size_t VictimFree = 0;
+        for (size_t i = 0; i < m_ShardCount; ++i)
+        {
+            size_t Free = m_Shards[i].pAllocator->ReadStatistics().MaxAllocationSize();
+            if (i != HomeShard && Free >= BlockSize && Free > VictimFree)
+            {
+                Victim = i;
+                VictimFree = Free;
+            }
+        }
+
+        if (Victim != HomeShard && TryAllocateFromShard(Victim, Size, Block))
+        {
+            m_StealCount.fetch_add(1, std::memory_order_relaxed);
+            return Block;
+        }
+
+        // The published sizes were stale; try every other shard
+        for (size_t i = 1; i < m_ShardCount; ++i)
+        {
+            size_t Index = (HomeShard + i) % m_ShardCount;
+            if (Index != Victim && TryAllocateFromShard(Index, Size, Block))
+            {
+                m_StealCount.fetch_add(1, std::memory_order_relaxed);
+                return Block;
+            }
+        }
+
+        throw(BuddySuballocatorException(BuddySuballocatorException::Type::Unavailable));
+    }
+
+    // Allocates with a home shard chosen from the calling thread's id
+    TBuddyBlock<_IndexType> Allocate(size_t Size)
+    {
+        return Allocate(Size, std::hash<std::thread::id>()(std::this_thread::get_id()));
+    }
+
+    // Non-throwing allocation: returns true on success, false if no shard has space
+    bool TryAllocate(size_t Size, size_t HomeShard, TBuddyBlock<_IndexType>& OutBlock)
+    {
+        try
+        {
+            OutBlock = Allocate(Size, HomeShard);
+            return true;
+        }
+        catch (BuddySuballocatorException&)
+        {
+            return false;
+        }
+    }
+
+    // Frees a block through the shard that owns its range
+    void Free(const TBuddyBlock<_IndexType>& Block)
+    {
+        TBuddyBlock<_IndexType> LocalBlock;
+        Shard& S = LocateBlock(Block, LocalBlock);
+        std::lock_guard<std::mutex> Lock(S.Mutex);
+        S.pAllocator->Free(LocalBlock);
+    }
+
+    // Non-throwing free: returns true if freed, false if block was not allocated
+    bool TryFree(const TBuddyBlock<_IndexType>& Block)
+    {
+        try
+        {
+            Free(Block);
+            return true;
+        }
+        catch (BuddySuballocatorException&)
+        {
+            return false;
+        }
+    }
+
+    bool IsBlockAllocated(const TBuddyBlock<_IndexType>& Block) const
+    {
+        size_t Index = size_t(Block.Start()) >> m_ShardOrder;
+        if (Index >= m_ShardCount || Block.Order() > m_ShardOrder)
+        {
+            return false;
+        }
+
+        TBuddyBlock<_IndexType> LocalBlock;
+        Shard& S = LocateBlock(Block, LocalBlock);
+        std::lock_guard<std::mutex> Lock(S.Mutex);
+        return S.pAllocator->IsBlockAllocated(LocalBlock);
+    }
+
+    // Free space across all shards
+    size_t TotalFree() const
+    {
+        size_t TotalFree = 0;
+        for (size_t i = 0; i < m_ShardCount; ++i)
+        {
+            TotalFree += m_Shards[i].pAllocator->ReadStatistics().FreeUnits;
+        }
+
+        return TotalFree;
+    }
+
+    // Largest block that any shard can currently allocate
+    size_t MaxAllocationSize() const
+    {
+        size_t MaxSize = 0;
+        for (size_t i = 0; i < m_ShardCount; ++i)
+        {
+            MaxSize = (std::max)(MaxSize, m_Shards[i].pAllocator->ReadStatistics().MaxAllocationSize());
+        }
+
+        return MaxSize;
+    }
+
+    // Free space in one shard
+    size_t ShardFree(size_t Index) const
+    {
+        return m_Shards[Index].pAllocator->ReadStatistics().FreeUnits;
+    }
+};
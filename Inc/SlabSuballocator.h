@@ -0,0 +1,309 @@
+//================================================================================================
+// SlabSuballocator
+//================================================================================================
+
+#pragma once
+
+#include <initializer_list>
+#include <stdexcept>
+#include "BuddySuballocator.h"
+
+//------------------------------------------------------------------------------------------------
+// TSlabSuballocator class
+//
+// Manages tiny allocations by carving slabs obtained from a TBuddySuballocator into fixed-size
+// slots.  Each size class has its own slot size, which need not be a power of two (e.g. 3, 5 or
+// 6 units), so small requests avoid both buddy rounding and the per-operation split/merge cost.
+//
+// All slabs are buddy blocks of the same order, so the slab owning an offset is found with a
+// shift.  Each slab tracks up to 64 slots with a bit mask (set bits are free slots), giving O(1)
+// allocate and free via bit scanning.  Slabs with at least one free slot are linked in a
+// per-size-class TIndexList, and a slab is returned to the buddy allocator as soon as it becomes
+// empty.
+//
+// Allocations are identified by their offset in the buddy allocator's space.
+//
+// _IndexType is the type of integers representing the allocation space.
+template<class _IndexType>
+class TSlabSuballocator
+{
+    static_assert(_IndexType(-1) > _IndexType(0), "_IndexType must be an unsigned type");
+
+    static constexpr size_t _MaxSlotsPerSlab = 64;
+
+    using _IndexNodeType = IndexNode<_IndexType>;
+    using _IndexListType = TIndexList<_IndexType, _IndexNodeType*>;
+
+    struct SizeClass
+    {
+        size_t SlotSize = 0;
+        size_t SlotCount = 0;
+        uint64_t EmptyMask = 0; // Free mask of a slab with no slots allocated
+        _IndexListType PartialSlabs; // Slabs with at least one free slot
+    };
+
+    struct Slab
+    {
+        uint64_t FreeMask = 0;
+        uint8_t ClassIndex = 0;
+        bool InUse = false;
+    };
+
+    TBuddySuballocator<_IndexType>& m_Allocator;
+    uint8_t m_SlabOrder;
+    size_t m_NumClasses = 0;
+    SizeClass* m_Classes = nullptr;
+    uint8_t* m_ClassForSize = nullptr; // Maps a requested size to the smallest fitting class
+    size_t m_MaxSlotSize = 0;
+    size_t m_NumSlabs = 0;
+    Slab* m_Slabs = nullptr;
+    _IndexNodeType* m_SlabLinks = nullptr;
+    size_t m_SlabsInUse = 0;
+
+    void Init(std::initializer_list<size_t> SlotSizes)
+    {
+        if (SlotSizes.size() == 0 || SlotSizes.size() > 256)
+        {
+            throw std::invalid_argument("Between 1 and 256 size classes are required");
+        }
+
+        for (size_t SlotSize : SlotSizes)
+        {
+            if (SlotSize == 0)
+            {
+                throw std::invalid_argument("Slot sizes must be nonzero");
+            }
+            m_MaxSlotSize = (std::max)(m_MaxSlotSize, SlotSize);
+        }
+
+        // Every slab must hold at least one slot of the largest class
+        if ((size_t(1) << m_SlabOrder) < m_MaxSlotSize)
+        {
+            m_SlabOrder = (uint8_t) Log2Ceil(m_MaxSlotSize);
+        }
+
+        size_t SlabSize = size_t(1) << m_SlabOrder;
+        for (size_t SlotSize : SlotSizes)
+        {
+            if (SlabSize / SlotSize > _MaxSlotsPerSlab)
+            {
+                throw std::invalid_argument("A slab may hold at most 64 slots of each class");
+            }
+        }
+
+        m_NumClasses = SlotSizes.size();
+        m_Classes = new SizeClass[m_NumClasses];
+
+        size_t ClassIndex = 0;
+        for (size_t SlotSize : SlotSizes)
+        {
+            auto& Class = m_Classes[ClassIndex++];
+            Class.SlotSize = SlotSize;
+            Class.SlotCount = SlabSize / SlotSize;
+            Class.EmptyMask = Class.SlotCount == 64 ? ~uint64_t(0) : (uint64_t(1) << Class.SlotCount) - 1;
+        }
+
+        // Map each size to the smallest class holding it, independent of the order given
+        m_ClassForSize = new uint8_t[m_MaxSlotSize + 1];
+        for (size_t Size = 1; Size <= m_MaxSlotSize; ++Size)
+        {
+            uint8_t Best = 0;
+            for (uint8_t Index = 0; Index < m_NumClasses; ++Index)
+            {
+                size_t SlotSize = m_Classes[Index].SlotSize;
+                if (SlotSize >= Size && (m_Classes[Best].SlotSize < Size || SlotSize < m_Classes[Best].SlotSize))
+                {
+                    Best = Index;
+                }
+            }
+            m_ClassForSize[Size] = Best;
+        }
+    }
+
+    // Makes sure the slab table covers the full capacity of the buddy allocator
+    void GrowSlabTable()
+    {
+        size_t NumSlabs = m_Allocator.GetCapacity() >> m_SlabOrder;
+        if (NumSlabs <= m_NumSlabs)
+        {
+            return;
+        }
+
+        Slab* pNewSlabs = new Slab[NumSlabs];
+        _IndexNodeType* pNewLinks = new _IndexNodeType[NumSlabs];
+        for (size_t i = 0; i < m_NumSlabs; ++i)
+        {
+            pNewSlabs[i] = m_Slabs[i];
+            pNewLinks[i] = m_SlabLinks[i];
+        }
+        delete[] m_Slabs;
+        delete[] m_SlabLinks;
+        m_Slabs = pNewSlabs;
+        m_SlabLinks = pNewLinks;
+        m_NumSlabs = NumSlabs;
+    }
+
+    void AllocateSlab(uint8_t ClassIndex)
+    {
+        auto Block = m_Allocator.Allocate(size_t(1) << m_SlabOrder);
+        GrowSlabTable();
+
+        _IndexType SlabIndex = _IndexType(Block.Start() >> m_SlabOrder);
+        auto& NewSlab = m_Slabs[SlabIndex];
+        auto& Class = m_Classes[ClassIndex];
+        NewSlab.FreeMask = Class.EmptyMask;
+        NewSlab.ClassIndex = ClassIndex;
+        NewSlab.InUse = true;
+        Class.PartialSlabs.PushFront(SlabIndex, m_SlabLinks);
+        ++m_SlabsInUse;
+    }
+
+    void FreeSlab(_IndexType SlabIndex)
+    {
+        m_Slabs[SlabIndex].InUse = false;
+        m_Allocator.Free(TBuddyBlock<_IndexType>(_IndexType(SlabIndex << m_SlabOrder), m_SlabOrder));
+        --m_SlabsInUse;
+    }
+
+public:
+    // Creates a slab suballocator with the default size classes of 1, 2, 3, 4, 5, 6 and 8 units.
+    // SlabSize is rounded up to a power of two and may hold at most 64 slots of the smallest
+    // class.
+    TSlabSuballocator(TBuddySuballocator<_IndexType>& Allocator, size_t SlabSize = 64) :
+        TSlabSuballocator(Allocator, SlabSize, { 1, 2, 3, 4, 5, 6, 8 }) {}
+
+    // Throws std::invalid_argument if SlotSizes is empty, holds a zero size, or any class would
+    // have more than 64 slots per slab.
+    TSlabSuballocator(TBuddySuballocator<_IndexType>& Allocator, size_t SlabSize, std::initializer_list<size_t> SlotSizes) :
+        m_Allocator(Allocator),
+        m_SlabOrder((uint8_t) Log2Ceil(SlabSize))
+    {
+        Init(SlotSizes);
+    }
+
+    // Any slabs still in use are returned to the buddy allocator
+    ~TSlabSuballocator()
+    {
+        for (size_t i = 0; i < m_NumSlabs; ++i)
+        {
+            if (m_Slabs[i].InUse)
+            {
+                FreeSlab(_IndexType(i));
+            }
+        }
+
+        delete[] m_Classes;
+        delete[] m_ClassForSize;
+        delete[] m_Slabs;
+        delete[] m_SlabLinks;
+    }
+
+    // Non-copyable
+    TSlabSuballocator(const TSlabSuballocator&) = delete;
+    TSlabSuballocator& operator=(const TSlabSuballocator&) = delete;
+
+    size_t MaxSlotSize() const { return m_MaxSlotSize; }
+    size_t SlabSize() const { return size_t(1) << m_SlabOrder; }
+    size_t SlabsInUse() const { return m_SlabsInUse; }
+
+    // Returns the slot size used for a given requested size
+    size_t GetSlotSize(size_t Size) const
+    {
+        return m_Classes[m_ClassForSize[Size ? Size : 1]].SlotSize;
+    }
+
+    // Allocates a slot of at least Size units and returns its offset.
+    // Throws Unavailable if Size exceeds MaxSlotSize() or no slab can be obtained.
+    _IndexType Allocate(size_t Size)
+    {
+        if (Size > m_MaxSlotSize)
+        {
+            throw(BuddySuballocatorException(BuddySuballocatorException::Type::Unavailable));
+        }
+
+        uint8_t ClassIndex = m_ClassForSize[Size ? Size : 1];
+        auto& Class = m_Classes[ClassIndex];
+        if (Class.PartialSlabs.Size() == 0)
+        {
+            AllocateSlab(ClassIndex);
+        }
+
+        _IndexType SlabIndex = Class.PartialSlabs.Begin().Index();
+        auto& CurrentSlab = m_Slabs[SlabIndex];
+        unsigned long Slot = BitScanLSB64(CurrentSlab.FreeMask);
+        CurrentSlab.FreeMask &= ~(uint64_t(1) << Slot);
+        if (CurrentSlab.FreeMask == 0)
+        {
+            // Slab is full
+            Class.PartialSlabs.Remove(SlabIndex, m_SlabLinks);
+        }
+
+        return _IndexType((size_t(SlabIndex) << m_SlabOrder) + Slot * Class.SlotSize);
+    }
+
+    // Non-throwing allocation: returns true on success, false if no space available
+    bool TryAllocate(size_t Size, _IndexType& OutOffset)
+    {
+        try
+        {
+            OutOffset = Allocate(Size);
+            return true;
+        }
+        catch (BuddySuballocatorException&)
+        {
+            return false;
+        }
+    }
+
+    // Non-throwing free: returns true if freed, false if the offset is not an allocated slot
+    bool TryFree(_IndexType Offset)
+    {
+        size_t SlabIndex = size_t(Offset) >> m_SlabOrder;
+        if (SlabIndex >= m_NumSlabs || !m_Slabs[SlabIndex].InUse)
+        {
+            return false;
+        }
+
+        auto& CurrentSlab = m_Slabs[SlabIndex];
+        auto& Class = m_Classes[CurrentSlab.ClassIndex];
+        size_t SlotOffset = size_t(Offset) - (SlabIndex << m_SlabOrder);
+        size_t Slot = SlotOffset / Class.SlotSize;
+        if (Slot * Class.SlotSize != SlotOffset || Slot >= Class.SlotCount)
+        {
+            return false;
+        }
+
+        uint64_t SlotMask = uint64_t(1) << Slot;
+        if (CurrentSlab.FreeMask & SlotMask)
+        {
+            return false;
+        }
+
+        bool WasFull = CurrentSlab.FreeMask == 0;
+        CurrentSlab.FreeMask |= SlotMask;
+
+        if (CurrentSlab.FreeMask == Class.EmptyMask)
+        {
+            // Slab is empty; return it to the buddy allocator
+            if (!WasFull)
+            {
+                Class.PartialSlabs.Remove(_IndexType(SlabIndex), m_SlabLinks);
+            }
+            FreeSlab(_IndexType(SlabIndex));
+        }
+        else if (WasFull)
+        {
+            Class.PartialSlabs.PushFront(_IndexType(SlabIndex), m_SlabLinks);
+        }
+
+        return true;
+    }
+
+    void Free(_IndexType Offset)
+    {
+        if (!TryFree(Offset))
+        {
+            throw(BuddySuballocatorException(BuddySuballocatorException::Type::NotAllocated));
+        }
+    }
+};
@@ -0,0 +1,262 @@
+//================================================================================================
+// SpscByteChannel
+//================================================================================================
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include "RingSuballocator.h"
+
+//------------------------------------------------------------------------------------------------
+// Contiguous range of bytes in a TSpscByteChannel buffer.  Data is null if the range is empty.
+struct ByteSpan
+{
+    uint8_t* Data = nullptr;
+    size_t Size = 0;
+};
+
+//------------------------------------------------------------------------------------------------
+// TSpscByteChannel class
+//
+// Single-producer, single-consumer queue of variable-length records over a caller-owned buffer.
+// Records are written and read in place:
+//
+//   Producer: BeginWrite(Size) -> fill span -> EndWrite() or CancelWrite() ... Publish()
+//   Consumer: PeekRead() -> use span -> ConsumeRead()
+//
+// The producer places records with a TRingSuballocator.  Each record is a length header of type
+// _IndexType followed by the payload, padded to _RecordAlignment bytes.  When a record would
+// straddle the end of the buffer, the producer first allocates the tail and writes a wrap marker
+// there, so every record is contiguous.  The tail stays allocated until the consumer has followed
+// the marker back to offset 0; ring padding could be reclaimed before the consumer reads the
+// marker.  A cancelled record stays allocated too; its space is filled with skip markers, one
+// per _RecordAlignment bytes, which the consumer steps over.
+//
+// Cursors count bytes monotonically and live on separate cache lines.  Publish makes every
+// ended record visible with one release store, so the consumer reads a batch of records per
+// acquire.  The consumer reports the bytes it has consumed, and the producer frees that many
+// bytes from its ring only when it runs out of space.
+//
+// The buffer must be aligned to _RecordAlignment bytes.  Its size is rounded down to a multiple
+// of _RecordAlignment and must fit in _IndexType.
+template<typename _IndexType>
+class TSpscByteChannel
+{
+    static constexpr size_t _CacheLineSize = 64;
+    static constexpr _IndexType _WrapMarker = _IndexType(-1);
+    static constexpr _IndexType _SkipMarker = _IndexType(-2);
+
+public:
+    static constexpr size_t _RecordAlignment = 8;
+    static constexpr size_t _HeaderSize = ((sizeof(_IndexType) + _RecordAlignment - 1) / _RecordAlignment) * _RecordAlignment;
+    static_assert(_HeaderSize == _RecordAlignment, "Skip markers assume a header fills one alignment unit");
+
+private:
+    uint8_t* m_pBuffer;
+    size_t m_Size;
+
+    // Producer state
+    alignas(_CacheLineSize) TRingSuballocator<_IndexType> m_Ring;
+    size_t m_WritePos = 0;
+    uint64_t m_WriteCursor = 0;
+    uint64_t m_ReclaimedBytes = 0;
+    _IndexType m_PendingOffset = 0;
+    size_t m_PendingSize = 0;
+    bool m_Writing = false;
+
+    // Consumer state
+    alignas(_CacheLineSize) uint64_t m_ReadCursor = 0;
+    uint64_t m_PublishedCache = 0;
+    uint64_t m_ConsumedBytes = 0;
+
+    alignas(_CacheLineSize) std::atomic<uint64_t> m_Published{ 0 };
+    alignas(_CacheLineSize) std::atomic<uint64_t> m_Consumed{ 0 };
+
+    static size_t RecordSize(size_t PayloadSize)
+    {
+        return ((_HeaderSize + PayloadSize + _RecordAlignment - 1) / _RecordAlignment) * _RecordAlignment;
+    }
+
+    _IndexType& Header(size_t Pos) const
+    {
+        return *reinterpret_cast<_IndexType*>(m_pBuffer + Pos);
+    }
+
+    // Frees the ring space of records the consumer has finished with
+    void ReclaimConsumed()
+    {
+        uint64_t Consumed = m_Consumed.load(std::memory_order_acquire);
+        m_Ring.Free(size_t(Consumed - m_ReclaimedBytes));
+        m_ReclaimedBytes = Consumed;
+    }
+
+    bool AllocateBytes(size_t Bytes, _IndexType& OutOffset)
+    {
+        if (m_Ring.TryAllocate(Bytes, 1, OutOffset))
+        {
+            return true;
+        }
+
+        ReclaimConsumed();
+        return m_Ring.TryAllocate(Bytes, 1, OutOffset);
+    }
+
+    void ConsumeBytes(size_t Bytes)
+    {
+        m_ReadCursor += Bytes;
+        m_ConsumedBytes += Bytes;
+        m_Consumed.store(m_ConsumedBytes, std::memory_order_release);
+    }
+
+public:
+    TSpscByteChannel(void* pBuffer, size_t Size) :
+        m_pBuffer(static_cast<uint8_t*>(pBuffer)),
+        m_Size(Size - Size % _RecordAlignment),
+        m_Ring(m_Size) {}
+
+    // Non-copyable
+    TSpscByteChannel(const TSpscByteChannel&) = delete;
+    TSpscByteChannel& operator=(const TSpscByteChannel&) = delete;
+
+    size_t Capacity() const { return m_Size; }
+
+    // Largest payload a single record can hold
+    size_t MaxRecordSize() const
+    {
+        return m_Size >= _HeaderSize ? (std::min)(m_Size - _HeaderSize, size_t(_SkipMarker) - 1) : 0;
+    }
+
+    //--------------------------------------------------------------------------------------------
+    // Producer thread
+
+    // Reserves space for a record of Size bytes and returns its payload.
+    // Returns an empty span if the channel is full or Size exceeds MaxRecordSize.  A full channel
+    // may be waiting for the consumer to follow a wrap marker, so Publish before waiting.
+    // Throws std::logic_error if the previous record has not been ended or cancelled.
+    ByteSpan BeginWrite(size_t Size)
+    {
+        if (m_Writing)
+        {
+            throw std::logic_error("BeginWrite called while a record is being written");
+        }
+
+        if (Size > MaxRecordSize())
+        {
+            return ByteSpan();
+        }
+
+        size_t Bytes = RecordSize(Size);
+        _IndexType Offset;
+        if (Bytes > m_Size - m_WritePos)
+        {
+            // The record doesn't fit before the end; send the consumer back to offset 0
+            if (!AllocateBytes(m_Size - m_WritePos, Offset))
+            {
+                return ByteSpan();
+            }
+
+            Header(m_WritePos) = _WrapMarker;
+            m_WriteCursor += m_Size - m_WritePos;
+            m_WritePos = 0;
+        }
+
+        if (!AllocateBytes(Bytes, Offset))
+        {
+            return ByteSpan();
+        }
+
+        m_PendingOffset = Offset;
+        m_PendingSize = Size;
+        m_Writing = true;
+        return ByteSpan{ m_pBuffer + size_t(Offset) + _HeaderSize, Size };
+    }
+
+    // Completes the record started by BeginWrite.  It becomes visible at the next Publish.
+    void EndWrite()
+    {
+        if (!m_Writing)
+        {
+            return;
+        }
+
+        size_t Bytes = RecordSize(m_PendingSize);
+        Header(size_t(m_PendingOffset)) = _IndexType(m_PendingSize);
+        m_WriteCursor += Bytes;
+        m_WritePos = (size_t(m_PendingOffset) + Bytes) % m_Size;
+        m_Writing = false;
+    }
+
+    // Abandons the record started by BeginWrite.  Its space is skipped by the consumer once
+    // published and reclaimed like any other record.
+    void CancelWrite()
+    {
+        if (!m_Writing)
+        {
+            return;
+        }
+
+        size_t Bytes = RecordSize(m_PendingSize);
+        for (size_t Pos = 0; Pos < Bytes; Pos += _RecordAlignment)
+        {
+            Header(size_t(m_PendingOffset) + Pos) = _SkipMarker;
+        }
+        m_WriteCursor += Bytes;
+        m_WritePos = (size_t(m_PendingOffset) + Bytes) % m_Size;
+        m_Writing = false;
+    }
+
+    // Makes all completed records visible to the consumer
+    void Publish()
+    {
+        m_Published.store(m_WriteCursor, std::memory_order_release);
+    }
+
+    //--------------------------------------------------------------------------------------------
+    // Consumer thread
+
+    // Returns the payload of the oldest published record without consuming it.
+    // Returns an empty span if no record is available.
+    ByteSpan PeekRead()
+    {
+        for (;;)
+        {
+            if (m_ReadCursor == m_PublishedCache)
+            {
+                m_PublishedCache = m_Published.load(std::memory_order_acquire);
+                if (m_ReadCursor == m_PublishedCache)
+                {
+                    return ByteSpan();
+                }
+            }
+
+            size_t Pos = size_t(m_ReadCursor % m_Size);
+            _IndexType Length = Header(Pos);
+            if (Length == _SkipMarker)
+            {
+                ConsumeBytes(_RecordAlignment);
+            }
+            else if (Length == _WrapMarker)
+            {
+                ConsumeBytes(m_Size - Pos);
+            }
+            else
+            {
+                return ByteSpan{ m_pBuffer + Pos + _HeaderSize, size_t(Length) };
+            }
+        }
+    }
+
+    // Consumes the record returned by PeekRead
+    void ConsumeRead()
+    {
+        ByteSpan Record = PeekRead();
+        if (!Record.Data)
+        {
+            return;
+        }
+
+        ConsumeBytes(RecordSize(Record.Size));
+    }
+};
@@ -0,0 +1,389 @@
+//================================================================================================
+// TlsfSuballocator
+//================================================================================================
+
+#pragma once
+
+#include "BuddySuballocator.h"
+
+//------------------------------------------------------------------------------------------------
+// Represents a logical sub-allocation made by a TTlsfSuballocator.
+// Start is the start of the allocation range.
+// Size is the exact size of the allocation.
+template<typename _IndexType>
+class TTlsfBlock
+{
+    _IndexType m_Start;
+    _IndexType m_Size;
+
+public:
+    TTlsfBlock() :
+        m_Start(0),
+        m_Size(0) {}
+
+    TTlsfBlock(_IndexType start, _IndexType size) :
+        m_Start(start),
+        m_Size(size) {}
+
+    _IndexType Start() const { return m_Start; }
+    size_t Size() const { return m_Size; }
+
+    bool operator==(const TTlsfBlock& o) const { return m_Start == o.m_Start && m_Size == o.m_Size; }
+    bool operator!=(const TTlsfBlock& o) const { return !operator==(o); }
+};
+
+//------------------------------------------------------------------------------------------------
+struct TlsfSuballocatorException
+{
+    enum class Type
+    {
+        Unavailable,
+        NotAllocated,
+    };
+
+    Type T;
+
+    TlsfSuballocatorException(Type t) : T(t) {}
+};
+
+//------------------------------------------------------------------------------------------------
+// TTlsfSuballocator class
+//
+// Manages allocation of logical ranges of integer values using the two-level segregated fit
+// (TLSF) algorithm.  Unlike TBuddySuballocator, allocations are not rounded up to a power of two;
+// each allocation occupies exactly the requested number of units.  Allocate and Free run in O(1).
+//
+// Free blocks are segregated into lists by size.  The first level splits sizes by power of two
+// and the second level splits each power-of-two range into _SLCount linear classes.  Sizes below
+// _SmallSize map directly to first-level class 0.  A first-level bitmap and one second-level
+// bitmap per first-level class record which lists are non-empty, so a suitable list is found
+// with two bit scans.  Requests are rounded up to the next class boundary before searching, so
+// any block in the found list is large enough (good-fit).
+//
+// As with TBuddySuballocator, there is no physical memory to hold intrusive links or boundary
+// tags, so they are kept in tables indexed by offset:
+//   - An IndexNode per unit links free blocks into the segregated TIndexLists.
+//   - A size per unit records each block's size at its first unit (header) and last unit
+//     (footer), so the previous block can be found from the unit before a block's start.
+//   - Bit arrays mark the first unit of every free and every allocated block.
+// Freed blocks are immediately coalesced with free physical neighbors.
+//
+// _IndexType is the type of integers representing the allocation space.  The capacity can be at
+// most the maximum value of _IndexType.
+template<class _IndexType>
+class TTlsfSuballocator
+{
+    static_assert(_IndexType(-1) > _IndexType(0), "_IndexType must be an unsigned type");
+
+    using _IndexNodeType = IndexNode<_IndexType>;
+    using _IndexListType = TIndexList<_IndexType, _IndexNodeType*>;
+    using _BitArrayType = TBitArray<_IndexType>;
+
+    static constexpr unsigned _SLBits = 4;
+    static constexpr unsigned _SLCount = 1 << _SLBits;
+    static constexpr size_t _SmallSize = size_t(1) << _SLBits;
+    static constexpr unsigned _FLCount = unsigned(sizeof(_IndexType) * 8) - _SLBits + 1;
+
+    size_t m_Capacity;
+    size_t m_FreeSize;
+    _IndexNodeType* m_Nodes;
+    _IndexType* m_BlockSizes;
+    _BitArrayType m_FreeBitArray;
+    _BitArrayType m_AllocatedBitArray;
+    _IndexListType m_FreeLists[_FLCount * _SLCount];
+    uint64_t m_FLBitmap = 0;
+    uint32_t m_SLBitmaps[_FLCount] = {};
+
+    // Maps a block size to its first and second level indices
+    static void Mapping(size_t Size, unsigned& FL, unsigned& SL)
+    {
+        if (Size < _SmallSize)
+        {
+            FL = 0;
+            SL = unsigned(Size);
+        }
+        else
+        {
+            unsigned MSB = unsigned(BitScanMSB64(Size));
+            FL = MSB - _SLBits + 1;
+            SL = unsigned(Size >> (MSB - _SLBits)) - _SLCount;
+        }
+    }
+
+    _IndexListType& FreeList(unsigned FL, unsigned SL)
+    {
+        return m_FreeLists[FL * _SLCount + SL];
+    }
+
+    void SetBlockSize(size_t Start, size_t Size)
+    {
+        m_BlockSizes[Start] = _IndexType(Size);
+        m_BlockSizes[Start + Size - 1] = _IndexType(Size);
+    }
+
+    void InsertFreeBlock(size_t Start, size_t Size)
+    {
+        unsigned FL, SL;
+        Mapping(Size, FL, SL);
+
+        SetBlockSize(Start, Size);
+        FreeList(FL, SL).PushFront(_IndexType(Start), m_Nodes);
+        m_FreeBitArray.Set(_IndexType(Start), true);
+        m_SLBitmaps[FL] |= uint32_t(1) << SL;
+        m_FLBitmap |= uint64_t(1) << FL;
+    }
+
+    void RemoveFreeBlock(size_t Start, size_t Size)
+    {
+        unsigned FL, SL;
+        Mapping(Size, FL, SL);
+
+        auto& List = FreeList(FL, SL);
+        List.Remove(_IndexType(Start), m_Nodes);
+        m_FreeBitArray.Set(_IndexType(Start), false);
+        if (List.Size() == 0)
+        {
+            m_SLBitmaps[FL] &= ~(uint32_t(1) << SL);
+            if (m_SLBitmaps[FL] == 0)
+            {
+                m_FLBitmap &= ~(uint64_t(1) << FL);
+            }
+        }
+    }
+
+    bool IsAllocated(const TTlsfBlock<_IndexType>& Block) const
+    {
+        return size_t(Block.Start()) < m_Capacity &&
+            m_AllocatedBitArray[Block.Start()] &&
+            m_BlockSizes[Block.Start()] == Block.Size();
+    }
+
+    TTlsfBlock<_IndexType> AllocateImpl(size_t Size)
+    {
+        if (Size == 0)
+        {
+            Size = 1;
+        }
+
+        if (Size <= m_FreeSize)
+        {
+            // Round up to the next class boundary so every block in the found list fits
+            size_t SearchSize = Size;
+            if (SearchSize >= _SmallSize)
+            {
+                SearchSize += (size_t(1) << (BitScanMSB64(SearchSize) - _SLBits)) - 1;
+            }
+
+            unsigned FL, SL;
+            Mapping(SearchSize, FL, SL);
+
+            if (FL < _FLCount)
+            {
+                uint32_t SLMap = m_SLBitmaps[FL] & (~uint32_t(0) << SL);
+                if (SLMap == 0)
+                {
+                    uint64_t FLMap = FL + 1 < 64 ? m_FLBitmap & (~uint64_t(0) << (FL + 1)) : 0;
+                    if (FLMap != 0)
+                    {
+                        FL = unsigned(BitScanLSB64(FLMap));
+                        SLMap = m_SLBitmaps[FL];
+                    }
+                }
+
+                if (SLMap != 0)
+                {
+                    SL = unsigned(BitScanLSB64(SLMap));
+
+                    size_t Start = FreeList(FL, SL).Begin().Index();
+                    size_t BlockSize = m_BlockSizes[Start];
+                    RemoveFreeBlock(Start, BlockSize);
+
+                    if (BlockSize > Size)
+                    {
+                        // Return the remainder to the free lists
+                        InsertFreeBlock(Start + Size, BlockSize - Size);
+                    }
+
+                    SetBlockSize(Start, Size);
+                    m_AllocatedBitArray.Set(_IndexType(Start), true);
+                    m_FreeSize -= Size;
+
+                    return TTlsfBlock<_IndexType>(_IndexType(Start), _IndexType(Size));
+                }
+            }
+        }
+
+        throw(TlsfSuballocatorException(TlsfSuballocatorException::Type::Unavailable));
+    }
+
+    void FreeImpl(const TTlsfBlock<_IndexType>& Block)
+    {
+        size_t Start = Block.Start();
+        size_t Size = Block.Size();
+
+        m_AllocatedBitArray.Set(_IndexType(Start), false);
+        m_FreeSize += Size;
+
+        // Coalesce with the next physical block
+        size_t Next = Start + Size;
+        if (Next < m_Capacity && m_FreeBitArray[_IndexType(Next)])
+        {
+            size_t NextSize = m_BlockSizes[Next];
+            RemoveFreeBlock(Next, NextSize);
+            Size += NextSize;
+        }
+
+        // Coalesce with the previous physical block, found through its footer
+        if (Start > 0)
+        {
+            size_t PrevSize = m_BlockSizes[Start - 1];
+            size_t PrevStart = Start - PrevSize;
+            if (m_FreeBitArray[_IndexType(PrevStart)])
+            {
+                RemoveFreeBlock(PrevStart, PrevSize);
+                Start = PrevStart;
+                Size += PrevSize;
+            }
+        }
+
+        InsertFreeBlock(Start, Size);
+    }
+
+public:
+    TTlsfSuballocator(size_t Capacity) :
+        m_Capacity(Capacity),
+        m_FreeSize(Capacity),
+        m_FreeBitArray(Capacity),
+        m_AllocatedBitArray(Capacity)
+    {
+        m_Nodes = new _IndexNodeType[m_Capacity];
+        m_BlockSizes = new _IndexType[m_Capacity];
+
+        if (m_Capacity > 0)
+        {
+            InsertFreeBlock(0, m_Capacity);
+        }
+    }
+
+    ~TTlsfSuballocator()
+    {
+        delete[] m_Nodes;
+        delete[] m_BlockSizes;
+    }
+
+    // Non-copyable
+    TTlsfSuballocator(const TTlsfSuballocator&) = delete;
+    TTlsfSuballocator& operator=(const TTlsfSuballocator&) = delete;
+
+    size_t GetCapacity() const { return m_Capacity; }
+
+    size_t TotalFree() const { return m_FreeSize; }
+
+    // Returns the size of the largest free block
+    size_t MaxAllocationSize() const
+    {
+        size_t MaxSize = 0;
+        if (m_FLBitmap != 0)
+        {
+            unsigned FL = unsigned(BitScanMSB64(m_FLBitmap));
+            unsigned SL = unsigned(BitScanMSB64(m_SLBitmaps[FL]));
+            const auto& List = m_FreeLists[FL * _SLCount + SL];
+            for (auto It = List.Begin(); ; It.MoveNext(m_Nodes))
+            {
+                MaxSize = (std::max)(MaxSize, size_t(m_BlockSizes[It.Index()]));
+                if (It == List.End()) break;
+            }
+        }
+
+        return MaxSize;
+    }
+
+    // Returns true if the block is currently allocated
+    bool IsBlockAllocated(const TTlsfBlock<_IndexType>& Block) const
+    {
+        return IsAllocated(Block);
+    }
+
+    TTlsfBlock<_IndexType> Allocate(size_t Size)
+    {
+        return AllocateImpl(Size);
+    }
+
+    // Non-throwing allocation: returns true on success, false if no space available
+    bool TryAllocate(size_t Size, TTlsfBlock<_IndexType>& OutBlock)
+    {
+        try
+        {
+            OutBlock = Allocate(Size);
+            return true;
+        }
+        catch (TlsfSuballocatorException&)
+        {
+            return false;
+        }
+    }
+
+    void Free(const TTlsfBlock<_IndexType>& Block)
+    {
+        if (!IsAllocated(Block))
+        {
+            throw(TlsfSuballocatorException(TlsfSuballocatorException::Type::NotAllocated));
+        }
+
+        FreeImpl(Block);
+    }
+
+    // Non-throwing free: returns true if freed, false if block was not allocated
+    bool TryFree(const TTlsfBlock<_IndexType>& Block)
+    {
+        if (!IsAllocated(Block))
+            return false;
+        FreeImpl(Block);
+        return true;
+    }
+
+    // Double the capacity of the allocator. Existing allocations keep their offsets.
+    // The new space is coalesced with the last block if it is free.
+    // Throws Unavailable if the new capacity cannot be represented by _IndexType.
+    void Grow()
+    {
+        size_t OldCapacity = m_Capacity;
+        size_t NewCapacity = OldCapacity ? OldCapacity * 2 : 1;
+        if (NewCapacity > size_t(_IndexType(-1)))
+        {
+            throw(TlsfSuballocatorException(TlsfSuballocatorException::Type::Unavailable));
+        }
+
+        _IndexNodeType* pNewNodes = new _IndexNodeType[NewCapacity];
+        _IndexType* pNewSizes = new _IndexType[NewCapacity];
+        for (size_t i = 0; i < OldCapacity; ++i)
+        {
+            pNewNodes[i] = m_Nodes[i];
+            pNewSizes[i] = m_BlockSizes[i];
+        }
+        delete[] m_Nodes;
+        delete[] m_BlockSizes;
+        m_Nodes = pNewNodes;
+        m_BlockSizes = pNewSizes;
+        m_FreeBitArray.Resize(NewCapacity);
+        m_AllocatedBitArray.Resize(NewCapacity);
+        m_Capacity = NewCapacity;
+
+        size_t Start = OldCapacity;
+        size_t Size = NewCapacity - OldCapacity;
+        if (OldCapacity > 0)
+        {
+            size_t LastSize = m_BlockSizes[OldCapacity - 1];
+            size_t LastStart = OldCapacity - LastSize;
+            if (m_FreeBitArray[_IndexType(LastStart)])
+            {
+                RemoveFreeBlock(LastStart, LastSize);
+                Start = LastStart;
+                Size += LastSize;
+            }
+        }
+
+        InsertFreeBlock(Start, Size);
+        m_FreeSize += NewCapacity - OldCapacity;
+    }
+};